@@ -0,0 +1,33 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "os.hpp"
+
+namespace qacpi {
+#ifdef QACPI_SLAB_ALLOCATOR
+	// All memory of the library is allocated through these. Small allocations are served from
+	// per size class free lists that are refilled a slab at a time from qacpi_os_malloc,
+	// slabs are kept for reuse and are never given back to the host.
+	void* allocate(size_t size);
+	void deallocate(void* ptr, size_t size);
+
+	struct SlabClassStats {
+		// the largest allocation served by the class
+		uint32_t size;
+		uint32_t slabs;
+		uint64_t allocations;
+		uint64_t frees;
+	};
+
+	// Fills up to count entries, returns the total number of size classes.
+	size_t get_slab_stats(SlabClassStats* stats, size_t count);
+#else
+	inline void* allocate(size_t size) {
+		return qacpi_os_malloc(size);
+	}
+
+	inline void deallocate(void* ptr, size_t size) {
+		qacpi_os_free(ptr, size);
+	}
+#endif
+}
@@ -7,6 +7,7 @@
 
 namespace qacpi {
 	struct NamespaceNode;
+	struct Interpreter;
 
 	struct StringView {
 		constexpr StringView() = default;
@@ -64,6 +65,45 @@ namespace qacpi {
 		Break
 	};
 
+	// NameString as encoded in aml, segments point to the packed 4 byte NameSegs
+	struct NamePath {
+		const uint8_t* segments;
+		uint32_t segment_count;
+		uint32_t parent_count;
+		bool absolute;
+	};
+
+	// limits for Context::evaluate_budgeted, zero means no limit
+	struct EvalBudget {
+		// number of statements to execute
+		uint64_t statements;
+		// wall clock time in milliseconds
+		uint64_t time_ms;
+	};
+
+	// one evaluation of Context::evaluate_batch, name is looked up as a child of node
+	struct EvalRequest {
+		NamespaceNode* node;
+		StringView name;
+		ObjectRef* args;
+		int arg_count;
+	};
+
+	// what a suspended async evaluation is blocked on
+	struct WaitCondition {
+		enum : uint8_t {
+			// out of budget, can be resumed right away
+			None,
+			Sleep,
+			Acquire,
+			Wait
+		} type;
+		// os handle of the mutex for Acquire or the event for Wait
+		void* handle;
+		// qacpi_os_timer() value at which the wait ends or times out, UINT64_MAX if it never times out
+		uint64_t deadline;
+	};
+
 	struct Context {
 		Status init(uintptr_t rsdp_phys, LogLevel log_level);
 
@@ -84,6 +124,35 @@ namespace qacpi {
 		Status evaluate(StringView name, ObjectRef& res, ObjectRef* args = nullptr, int arg_count = 0);
 		Status evaluate(NamespaceNode* node, StringView name, ObjectRef& res, ObjectRef* args = nullptr, int arg_count = 0);
 
+		// Like evaluate but returns Status::Suspended and sets eval once the budget runs out, the
+		// evaluation must then be continued with resume or dropped with abort_evaluation.
+		// Mutexes acquired by the method stay held while it is suspended, they are owned by the
+		// evaluation rather than the thread. It may be resumed on any thread and interleaved with
+		// other evaluations, but then the os mutexes must allow being released by another thread.
+		Status evaluate_budgeted(
+			StringView name,
+			ObjectRef& res,
+			const EvalBudget& budget,
+			Interpreter*& eval,
+			ObjectRef* args = nullptr,
+			int arg_count = 0);
+		// continues a suspended evaluation, eval stays valid only if Status::Suspended is returned again
+		Status resume(Interpreter* eval, ObjectRef& res, const EvalBudget& budget);
+		// Like evaluate_budgeted but Sleep, Acquire, Wait and calls to serialized methods suspend the
+		// evaluation instead of blocking, wait is set to what it waits for. The blocked op is retried on resume_async, it may be
+		// resumed early but it has to be resumed by the deadline for timeouts to be accurate.
+		// The os mutex and event are only polled, the os layer must not acquire or reset them.
+		Status evaluate_async(
+			StringView name,
+			ObjectRef& res,
+			const EvalBudget& budget,
+			Interpreter*& eval,
+			WaitCondition& wait,
+			ObjectRef* args = nullptr,
+			int arg_count = 0);
+		Status resume_async(Interpreter* eval, ObjectRef& res, const EvalBudget& budget, WaitCondition& wait);
+		void abort_evaluation(Interpreter* eval);
+
 		Status evaluate_int(StringView name, uint64_t& res, ObjectRef* args = nullptr, int arg_count = 0);
 		Status evaluate_int(NamespaceNode* node, StringView name, uint64_t& res, ObjectRef* args = nullptr, int arg_count = 0);
 		Status evaluate_package(StringView name, ObjectRef& res, ObjectRef* args = nullptr, int arg_count = 0);
@@ -91,6 +160,16 @@ namespace qacpi {
 		Status evaluate_buffer(StringView name, Buffer& res, ObjectRef* args = nullptr, int arg_count = 0);
 		Status evaluate_buffer(NamespaceNode* node, StringView name, Buffer& res, ObjectRef* args = nullptr, int arg_count = 0);
 
+		// Evaluates every request like evaluate(node, name, ...) with a single interpreter, the result
+		// and status of each request are stored at the same index of results and statuses.
+		// Only fails as a whole if no interpreter can be allocated, the status of the first method
+		// and every request after it is then NoMemory.
+		Status evaluate_batch(const EvalRequest* requests, ObjectRef* results, Status* statuses, size_t count);
+
+		// Whether evaluating node has no side effects, which is always true for objects other than methods.
+		// Methods are analyzed on the first query or evaluation, the results of constant ones are reused.
+		bool is_pure(NamespaceNode* node);
+
 		Status init_namespace();
 
 		void register_address_space_handler(RegionSpaceHandler* handler);
@@ -149,6 +228,9 @@ namespace qacpi {
 		}
 
 		ObjectRef get_pkg_element(ObjectRef& pkg, uint32_t index);
+		// Like get_pkg_element but only for integers, returns false if the element doesn't exist
+		// or isn't an integer. Doesn't allocate unless the element is a reference or a field.
+		bool get_pkg_int(ObjectRef& pkg, uint32_t index, uint64_t& res);
 
 		constexpr NamespaceNode* get_root() {
 			return root;
@@ -162,6 +244,7 @@ namespace qacpi {
 	private:
 		friend struct Interpreter;
 		friend struct OpRegion;
+		friend struct PurityAnalyzer;
 
 		enum class SearchFlags {
 			Create,
@@ -181,9 +264,52 @@ namespace qacpi {
 		}
 
 		NamespaceNode* create_or_find_node(NamespaceNode* start, void* method_frame, StringView name, SearchFlags flags);
+		NamespaceNode* create_or_find_node(NamespaceNode* start, void* method_frame, const NamePath& path, SearchFlags flags);
+		NamespaceNode* create_child(NamespaceNode* parent, const char* segment, void* method_frame);
+
+		Interpreter* get_interpreter();
+		void put_interpreter(Interpreter* interp);
+		Status start_evaluation(
+			StringView name,
+			ObjectRef& res,
+			const EvalBudget& budget,
+			bool async,
+			Interpreter*& eval,
+			ObjectRef* args,
+			int arg_count);
+
+		static constexpr uint32_t CONSTANT_ONES = 0x100;
+		static constexpr uint32_t CONSTANT_NULL_TARGET = 0x101;
+		static constexpr uint32_t CONSTANT_COUNT = 0x102;
+
+		ObjectRef get_constant(uint32_t index);
+		bool is_constant(const ObjectRef& obj) const;
+
+		// Returns the cache shared by all methods with the same body and whether the body passed
+		// verify_aml in verified, the body is only verified if no identical one was seen before.
+		SharedPtr<MethodCache> share_method_body(const uint8_t* aml, uint32_t size, bool& verified);
+		// drops the bodies within aml that is about to be freed
+		void forget_method_bodies(const uint8_t* aml, uint32_t size);
+
+		struct MethodBody {
+			uint64_t hash;
+			const uint8_t* aml;
+			uint32_t size;
+			bool verified;
+			SharedPtr<MethodCache> cache;
+		};
 
 		NamespaceNode* root {};
 		NamespaceNode* all_nodes {};
+		uint64_t ns_generation {};
+		// idle interpreters kept with their grown stacks for reuse
+		Interpreter* free_interpreters {};
+		// shared integers 0-0xFF, Ones and NullTarget, these must never be modified in place
+		ObjectRef* constants {};
+		// open addressed by content hash, forgotten bodies keep their slot with a null aml
+		MethodBody* method_bodies {};
+		uint32_t method_body_count {};
+		uint32_t method_body_cap {};
 		Mutex* gl {};
 		ObjectRef global_locals[8] {
 			ObjectRef::empty(), ObjectRef::empty(), ObjectRef::empty(),
@@ -12,12 +12,85 @@ namespace qacpi {
 	struct Debug {};
 	struct Device {};
 
+	struct NamespaceNode;
+
+	struct MethodCache {
+		constexpr MethodCache() = default;
+		~MethodCache();
+
+		constexpr MethodCache(const MethodCache&) = delete;
+		constexpr MethodCache& operator=(const MethodCache&) = delete;
+
+		bool init(uint32_t new_size);
+
+		// decoded form of the aml at the same offset in the method body
+		struct Entry {
+			uint32_t value;
+			enum : uint8_t {
+				None,
+				Op,
+				Name,
+				PkgLength
+			} kind;
+			uint8_t width;
+		};
+
+		Entry* entries {};
+		uint32_t size {};
+		// value of a Name entry is its index + 1 in the MethodNames of each method
+		uint32_t name_count {};
+		// the entries are only allocated once a method using this cache is invoked again
+		bool invoked {};
+	};
+
+	// nodes the names in a method body were last resolved to, these depend on the scope
+	// so unlike MethodCache they are never shared between methods
+	struct MethodNames {
+		constexpr MethodNames() = default;
+		~MethodNames();
+
+		constexpr MethodNames(const MethodNames&) = delete;
+		constexpr MethodNames& operator=(const MethodNames&) = delete;
+
+		struct Entry {
+			NamespaceNode* scope;
+			NamespaceNode* node;
+			uint64_t generation;
+		};
+
+		Entry* get(uint32_t index);
+
+		Entry* entries {};
+		uint32_t count {};
+	};
+
+	struct Object;
+
+	using ObjectRef = SharedPtr<Object>;
+
+	enum class MethodPurity : uint8_t {
+		Unknown,
+		Analyzing,
+		Impure,
+		// no side effects but the result depends on the arguments or the namespace
+		Pure,
+		// the result only depends on the method body
+		Constant
+	};
+
 	struct Method {
 		const uint8_t* aml {};
 		SharedPtr<Mutex> mutex {SharedPtr<Mutex>::empty()};
 		uint32_t size {};
 		uint8_t arg_count {};
 		bool serialized {};
+		bool verified {};
+		// computed by analyze_purity on first use
+		MethodPurity purity {};
+		SharedPtr<MethodCache> cache {SharedPtr<MethodCache>::empty()};
+		SharedPtr<MethodNames> names {SharedPtr<MethodNames>::empty()};
+		// result of a Constant method, callers get a copy
+		ObjectRef memo {ObjectRef::empty()};
 
 		bool clone(const Method& other) {
 			if (other.serialized) {
@@ -34,6 +107,10 @@ namespace qacpi {
 			size = other.size;
 			arg_count = other.arg_count;
 			serialized = other.serialized;
+			verified = other.verified;
+			purity = other.purity;
+			cache = other.cache;
+			memo = other.memo;
 			return true;
 		}
 
@@ -52,7 +129,10 @@ namespace qacpi {
 		bool init(const void* new_data, uint32_t new_size);
 		bool init_with_size(uint32_t new_size);
 
+		// shares the contents with other, they are only copied by unshare
 		bool clone(const Buffer& other);
+		// makes the contents private to this buffer, has to be called before writing through data()
+		bool unshare();
 
 		[[nodiscard]] inline uint8_t* data() const {
 			return _data->data;
@@ -62,19 +142,19 @@ namespace qacpi {
 			return _data->size;
 		}
 
-		inline uint8_t* leak() {
-			auto ptr = _data->data;
-			_data->data = nullptr;
-			_data->size = 0;
-			return ptr;
-		}
+		// returns the contents as an allocation of size() bytes that the caller has to free
+		uint8_t* leak();
 
 	private:
+		uint8_t* alloc(uint32_t size);
+
 		struct Data {
 			~Data();
 
 			uint8_t* data {};
 			uint32_t size {};
+			// small buffers are stored here so they share the allocation of Data
+			uint8_t inline_storage[24];
 		};
 
 		SharedPtr<Data> _data {};
@@ -115,10 +195,6 @@ namespace qacpi {
 
 	struct ThermalZone {};
 
-	struct Object;
-
-	using ObjectRef = SharedPtr<Object>;
-
 	struct Ref {
 		enum {
 			RefOf,
@@ -126,6 +202,10 @@ namespace qacpi {
 			Local
 		} type;
 		ObjectRef inner;
+		// set by Index into a package, inner is only a copy of the element while the package is packed
+		// and may be shared with copies of the package until something is stored through the reference
+		ObjectRef owner {ObjectRef::empty()};
+		uint32_t index {};
 	};
 
 	struct Package {
@@ -138,7 +218,11 @@ namespace qacpi {
 
 		bool init(uint32_t new_size);
 
+		// shares the elements with other unless some of them are referenced from elsewhere,
+		// they are only copied by unshare
 		bool clone(const Package& other);
+		// makes the elements private to this package, has to be called before handing them out
+		bool unshare();
 
 		[[nodiscard]] constexpr uint32_t size() const {
 			return data->element_count;
@@ -148,10 +232,25 @@ namespace qacpi {
 		friend struct Interpreter;
 		friend struct Context;
 
+		bool init_integers(uint32_t new_size);
+		bool copy(const Package& other);
+		// elements are the PackageElementList in aml, it has to be accepted by scan_package_literal
+		void init_lazy(const uint8_t* aml, uint32_t aml_size, uint32_t new_size);
+		// decodes the elements of a lazy package, no-op if it isn't lazy
+		bool materialize();
+		// converts a packed package to element objects, no-op if it isn't packed
+		bool box();
+
+		// packages with only integer elements are stored in integers instead of elements
+		// until an element object is needed, at most one of the two is allocated.
+		// package literals made of plain data are only decoded from aml on first access.
 		struct Data {
 			~Data();
 
 			ObjectRef* elements;
+			uint64_t* integers;
+			const uint8_t* aml;
+			uint32_t aml_size;
 			uint32_t element_count;
 		};
 
@@ -192,8 +291,6 @@ namespace qacpi {
 		bool index;
 	};
 
-	struct NamespaceNode;
-
 	struct NullTarget {};
 
 	struct Object {
@@ -221,6 +318,20 @@ namespace qacpi {
 			return data.get<Device>() || data.get<Processor>();
 		}
 
+		// empty objects and NullTarget are reported as Uninitialized
+		[[nodiscard]] inline ObjectType type() const {
+			constexpr ObjectType TYPES[] {
+				ObjectType::Uninitialized,
+				ObjectType::Uninitialized, ObjectType::Integer, ObjectType::String, ObjectType::Buffer,
+				ObjectType::Package, ObjectType::Field, ObjectType::Device, ObjectType::Event,
+				ObjectType::Method, ObjectType::Mutex, ObjectType::OpRegion, ObjectType::PowerRes,
+				ObjectType::Processor, ObjectType::ThermalZone, ObjectType::BufferField,
+				ObjectType::Debug, ObjectType::Ref, ObjectType::Uninitialized
+			};
+			static_assert(sizeof(TYPES) / sizeof(*TYPES) == decltype(data)::TYPE_COUNT + 1);
+			return TYPES[data.index()];
+		}
+
 		Variant<
 			Uninitialized, uint64_t, String, Buffer,
 			Package, Field, Device, Event,
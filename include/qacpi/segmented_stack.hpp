@@ -0,0 +1,88 @@
+#pragma once
+#include "utility.hpp"
+#include "allocator.hpp"
+
+namespace qacpi {
+	// A stack stored in chunks of N elements, elements never move once pushed.
+	// Chunks are kept around after popping so that they can be reused.
+	template<typename T, size_t N>
+	class SegmentedStack {
+	public:
+		constexpr SegmentedStack() = default;
+		constexpr SegmentedStack(const SegmentedStack&) = delete;
+		constexpr SegmentedStack& operator=(const SegmentedStack&) = delete;
+
+		~SegmentedStack() {
+			while (_size) {
+				pop_discard();
+			}
+
+			auto* chunk = first.next;
+			while (chunk) {
+				auto* next = chunk->next;
+				chunk->~Chunk();
+				deallocate(chunk, sizeof(Chunk));
+				chunk = next;
+			}
+		}
+
+		[[nodiscard]] T* push() {
+			if (_size && _size % N == 0) {
+				if (!current->next) {
+					auto* mem = allocate(sizeof(Chunk));
+					if (!mem) {
+						return nullptr;
+					}
+					auto* chunk = construct<Chunk>(mem);
+					chunk->prev = current;
+					current->next = chunk;
+				}
+				current = current->next;
+			}
+
+			return construct<T>(&current->data.elements[_size++ % N]);
+		}
+
+		void pop_discard() {
+			current->data.elements[--_size % N].~T();
+			if (_size && _size % N == 0) {
+				current = current->prev;
+			}
+		}
+
+		constexpr T& operator[](size_t index) {
+			auto* chunk = current;
+			for (size_t i = (_size - 1) / N; i > index / N; --i) {
+				chunk = chunk->prev;
+			}
+			return chunk->data.elements[index % N];
+		}
+
+		[[nodiscard]] constexpr size_t size() const {
+			return _size;
+		}
+
+		[[nodiscard]] constexpr bool is_empty() const {
+			return !_size;
+		}
+
+		constexpr T& back() {
+			return current->data.elements[(_size - 1) % N];
+		}
+
+	private:
+		struct Chunk {
+			union Data {
+				Data() {}
+				~Data() {}
+				T elements[N];
+			} data;
+			Chunk* prev {};
+			Chunk* next {};
+		};
+
+		Chunk first {};
+		Chunk* current {&first};
+		size_t _size {};
+	};
+}
@@ -1,8 +1,12 @@
 #pragma once
 #include "utility.hpp"
-#include "os.hpp"
+#include "allocator.hpp"
 
 namespace qacpi {
+	// The reference count is stored in front of the object in the same allocation,
+	// so a SharedPtr is a single pointer. With QACPI_ATOMIC_REFCOUNT the count is updated
+	// atomically so references to the same object can be copied and dropped from several
+	// threads, the object itself is still not synchronized.
 	template<typename T>
 	class SharedPtr {
 	public:
@@ -12,52 +16,33 @@ namespace qacpi {
 
 		template<typename... Args>
 		explicit SharedPtr(Args&&... args) {
-			auto* storage = static_cast<char*>(qacpi_os_malloc(sizeof(T) + sizeof(size_t)));
-			if (storage) {
-				ptr = construct<T>(storage, forward<Args&&>(args)...);
-				refs = construct<size_t>(storage + sizeof(T), size_t {1});
-			}
-			else {
-				ptr = nullptr;
-				refs = nullptr;
+			ptr = static_cast<Block*>(allocate(sizeof(Block)));
+			if (ptr) {
+				ptr->refs = 1;
+				construct<T>(&ptr->value, forward<Args&&>(args)...);
 			}
 		}
 
 		constexpr SharedPtr(SharedPtr&& other) noexcept {
 			ptr = other.ptr;
-			refs = other.refs;
 			other.ptr = nullptr;
-			other.refs = nullptr;
 		}
 
 		constexpr SharedPtr(const SharedPtr& other) {
 			ptr = other.ptr;
-			refs = other.refs;
-			if (refs) {
-				++*refs;
+			if (ptr) {
+				retain();
 			}
 		}
 
 		constexpr ~SharedPtr() {
-			if (refs) {
-				if (--*refs == 0) {
-					ptr->~T();
-					qacpi_os_free(ptr, sizeof(T) + sizeof(size_t));
-				}
-			}
+			release();
 		}
 
 		constexpr SharedPtr& operator=(SharedPtr&& other) noexcept {
-			if (refs) {
-				if (--*refs == 0) {
-					ptr->~T();
-					qacpi_os_free(ptr, sizeof(T) + sizeof(size_t));
-				}
-			}
+			release();
 			ptr = other.ptr;
-			refs = other.refs;
 			other.ptr = nullptr;
-			other.refs = nullptr;
 			return *this;
 		}
 
@@ -66,39 +51,47 @@ namespace qacpi {
 				return *this;
 			}
 
-			if (refs) {
-				if (--*refs == 0) {
-					ptr->~T();
-					qacpi_os_free(ptr, sizeof(T) + sizeof(size_t));
-				}
-			}
+			release();
 			ptr = other.ptr;
-			refs = other.refs;
-			if (refs) {
-				++*refs;
+			if (ptr) {
+				retain();
 			}
 
 			return *this;
 		}
 
 		constexpr T* operator->() {
-			return ptr;
+			return &ptr->value;
 		}
 
 		constexpr const T* operator->() const {
-			return ptr;
+			return &ptr->value;
 		}
 
 		constexpr T& operator*() {
-			return *ptr;
+			return ptr->value;
 		}
 
 		constexpr const T& operator*() const {
-			return *ptr;
+			return ptr->value;
 		}
 
 		[[nodiscard]] constexpr size_t ref_count() const {
-			return *refs;
+#ifdef QACPI_ATOMIC_REFCOUNT
+			return __atomic_load_n(&ptr->refs, __ATOMIC_RELAXED);
+#else
+			return ptr->refs;
+#endif
+		}
+
+		// acquire so writes made through references dropped on other threads are visible
+		// before the object is modified in place
+		[[nodiscard]] constexpr bool is_unique() const {
+#ifdef QACPI_ATOMIC_REFCOUNT
+			return __atomic_load_n(&ptr->refs, __ATOMIC_ACQUIRE) == 1;
+#else
+			return ptr->refs == 1;
+#endif
 		}
 
 		constexpr explicit operator bool() const {
@@ -107,9 +100,38 @@ namespace qacpi {
 
 	private:
 		struct Empty {};
-		constexpr explicit SharedPtr(Empty) : ptr {nullptr}, refs {nullptr} {}
+		constexpr explicit SharedPtr(Empty) : ptr {nullptr} {}
+
+		struct Block {
+			size_t refs;
+			union {
+				T value;
+			};
+		};
+
+		constexpr void retain() {
+#ifdef QACPI_ATOMIC_REFCOUNT
+			__atomic_fetch_add(&ptr->refs, 1, __ATOMIC_RELAXED);
+#else
+			++ptr->refs;
+#endif
+		}
+
+		constexpr void release() {
+			if (!ptr) {
+				return;
+			}
+#ifdef QACPI_ATOMIC_REFCOUNT
+			// acquire so the destructor sees all writes made through other references
+			if (__atomic_sub_fetch(&ptr->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+#else
+			if (--ptr->refs == 0) {
+#endif
+				ptr->value.~T();
+				deallocate(ptr, sizeof(Block));
+			}
+		}
 
-		T* ptr;
-		size_t* refs;
+		Block* ptr;
 	};
 }
@@ -1,6 +1,6 @@
 #pragma once
 #include "utility.hpp"
-#include "os.hpp"
+#include "allocator.hpp"
 
 namespace qacpi {
 	template<typename T, size_t N>
@@ -74,7 +74,7 @@ namespace qacpi {
 			}
 
 			if (ptr) {
-				qacpi_os_free(ptr, cap * sizeof(T));
+				deallocate(ptr, cap * sizeof(T));
 			}
 		}
 
@@ -94,7 +94,7 @@ namespace qacpi {
 			}
 
 			if (ptr) {
-				qacpi_os_free(ptr, cap * sizeof(T));
+				deallocate(ptr, cap * sizeof(T));
 			}
 
 			_size = other._size;
@@ -218,7 +218,7 @@ namespace qacpi {
 				if (_size + amount > new_cap) {
 					new_cap = _size + amount;
 				}
-				auto new_ptr = static_cast<T*>(qacpi_os_malloc(new_cap * sizeof(T)));
+				auto new_ptr = static_cast<T*>(allocate(new_cap * sizeof(T)));
 				if (!new_ptr) {
 					return false;
 				}
@@ -226,7 +226,7 @@ namespace qacpi {
 					construct<T>(&new_ptr[i], move(ptr[i]));
 				}
 				if (ptr) {
-					qacpi_os_free(ptr, cap * sizeof(T));
+					deallocate(ptr, cap * sizeof(T));
 				}
 				ptr = new_ptr;
 				cap = new_cap;
@@ -13,6 +13,8 @@ namespace qacpi {
 		Unsupported,
 		InternalError,
 		EndOfResources,
-		InvalidResource
+		InvalidResource,
+		// a budgeted evaluation ran out of its budget and can be resumed
+		Suspended
 	};
 }
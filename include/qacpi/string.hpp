@@ -17,7 +17,10 @@ namespace qacpi {
 		bool init(const char* str, size_t size);
 		bool init_with_size(size_t size);
 
+		// shares the contents with other, they are only copied by unshare
 		bool clone(const String& other);
+		// makes the contents private to this string, has to be called before writing through data()
+		bool unshare();
 
 		constexpr char* data() {
 			return _data->ptr;
@@ -40,11 +43,15 @@ namespace qacpi {
 		}
 
 	private:
+		char* alloc(size_t size);
+
 		struct Data {
 			~Data();
 
 			char* ptr {};
 			size_t size {};
+			// short strings are stored here so they share the allocation of Data
+			char inline_storage[24];
 		};
 		SharedPtr<Data> _data {};
 		bool _is_path {};
@@ -17,12 +17,13 @@ namespace qacpi {
 
 		bool clone(const Mutex& other);
 
-		bool is_owned_by_thread();
+		bool is_owned_by(void* key);
 
-		Status lock(uint16_t timeout_ms);
+		Status lock(uint16_t timeout_ms, void* key);
 		Status unlock();
 
 		void* handle {};
+		// the thread or the suspendable evaluation holding the mutex
 		void* owner {};
 		Mutex* prev {};
 		Mutex* next {};
@@ -46,26 +46,26 @@ namespace qacpi {
 
 		inline Variant(Variant&& other) noexcept {
 			id = other.id;
-			(move_from<Types>(other) || ...);
+			if (id) {
+				MOVE[id](&storage, &other.storage);
+				other.id = 0;
+			}
 		}
 
 		constexpr Variant(const Variant&) = delete;
 		constexpr Variant& operator=(const Variant&) = delete;
 
 		bool clone(Variant& res) const {
-			bool success;
-			(res.clone_from<Types>(*this, success) || ...);
-			return success;
+			res.reset();
+			res.id = id;
+			return !id || CLONE[id](&res.storage, &storage);
 		}
 
 		template<typename T> requires(IsAny<T, Types...>::value)
 		inline Variant& operator=(T&& value) {
 			constexpr size_t ID = TypeIndex<T, Types...>::value;
 
-			if (id) {
-				(destroy<Types>() || ...);
-			}
-
+			reset();
 			construct<T>(&storage, move(value));
 			id = ID;
 
@@ -78,10 +78,7 @@ namespace qacpi {
 		inline Variant& operator=(const T& value) {
 			constexpr size_t ID = TypeIndex<T, Types...>::value;
 
-			if (id) {
-				(destroy<Types>() || ...);
-			}
-
+			reset();
 			construct<T>(&storage, value);
 			id = ID;
 
@@ -127,16 +124,19 @@ namespace qacpi {
 
 		template<typename Visitor>
 		void visit(Visitor&& visitor) {
-			(visit_internal<Visitor, Types>(visitor) || ...);
+			using V = remove_reference_t<Visitor>;
+			static constexpr void (*VISIT[])(V&, void*) {&visit_none<V>, &visit_one<V, Types>...};
+			VISIT[id](visitor, &storage);
 		}
 
 		inline Variant& operator=(Variant&& other) noexcept {
-			if (id) {
-				(destroy<Types>() || ...);
-			}
+			reset();
 
 			id = other.id;
-			(move_from<Types>(other) || ...);
+			if (id) {
+				MOVE[id](&storage, &other.storage);
+				other.id = 0;
+			}
 
 			return *this;
 		}
@@ -146,90 +146,70 @@ namespace qacpi {
 		}
 
 		~Variant() {
-			if (id) {
-				(destroy<Types>() || ...);
-			}
+			reset();
 		}
 
+		static constexpr size_t TYPE_COUNT = sizeof...(Types);
+
 	private:
-		template<typename Visitor, typename T> requires requires(Visitor& visitor, T& arg) {
-			visitor(arg);
-		}
-		inline bool visit_internal(Visitor& visitor) {
-			constexpr size_t ID = TypeIndex<T, Types...>::value;
-			if (id == ID) {
-				visitor(*reinterpret_cast<T*>(&storage));
-				return true;
-			}
-			else {
-				return false;
+		// operations on the alternatives are dispatched through tables indexed by id,
+		// index 0 is the empty state and is never called
+		inline void reset() {
+			if (id) {
+				DESTROY[id](&storage);
+				id = 0;
 			}
 		}
+
+		template<typename Visitor>
+		static void visit_none(Visitor&, void*) {}
+
 		template<typename Visitor, typename T>
-		inline bool visit_internal(Visitor&) {
-			return false;
+		static void visit_one(Visitor& visitor, void* storage) {
+			if constexpr (requires(Visitor& visitor, T& arg) {
+				visitor(arg);
+			}) {
+				visitor(*static_cast<T*>(storage));
+			}
 		}
 
 		template<typename T>
-		inline bool destroy() {
-			constexpr size_t ID = TypeIndex<T, Types...>::value;
-			if (id == ID) {
-				reinterpret_cast<T*>(&storage)->~T();
-				return true;
-			}
-			else {
-				return false;
-			}
+		static void destroy_one(void* storage) {
+			static_cast<T*>(storage)->~T();
 		}
 
+		// the moved from value is left as is, the source becomes empty without destroying it
 		template<typename T>
-		inline bool move_from(Variant& other) {
-			constexpr size_t ID = TypeIndex<T, Types...>::value;
-			if (other.id == ID) {
-				construct<T>(&storage, move(*reinterpret_cast<T*>(&other.storage)));
-				other.id = 0;
-				return true;
-			}
-			else {
-				return false;
-			}
+		static void move_one(void* storage, void* other) {
+			construct<T>(storage, move(*static_cast<T*>(other)));
 		}
 
 		template<typename T>
-		inline bool clone_from(const Variant& other, bool& success) {
-			constexpr size_t ID = TypeIndex<T, Types...>::value;
-			if (other.id == ID) {
-				if (id) {
-					(destroy<Types>() || ...);
-				}
-				id = ID;
-
-				auto& value = *reinterpret_cast<const T*>(&other.storage);
-				T* ptr;
-				if constexpr (requires {
-					T {value};
-				}) {
-					ptr = construct<T>(&storage, value);
-				}
-				else {
-					ptr = construct<T>(&storage);
-				}
-				if constexpr (requires {
-					ptr->clone(value);
-				}) {
-					success = ptr->clone(value);
-				}
-				else {
-					success = true;
-				}
-
-				return true;
+		static bool clone_one(void* storage, const void* other) {
+			auto& value = *static_cast<const T*>(other);
+			T* ptr;
+			if constexpr (requires {
+				T {value};
+			}) {
+				ptr = construct<T>(storage, value);
+			}
+			else {
+				ptr = construct<T>(storage);
+			}
+			if constexpr (requires {
+				ptr->clone(value);
+			}) {
+				return ptr->clone(value);
 			}
 			else {
-				return false;
+				return true;
 			}
 		}
 
+		static constexpr void (*DESTROY[])(void*) {nullptr, &destroy_one<Types>...};
+		static constexpr void (*MOVE[])(void*, void*) {nullptr, &move_one<Types>...};
+		static constexpr bool (*CLONE[])(void*, const void*) {nullptr, &clone_one<Types>...};
+
 		size_t id {};
 		alignas(max<alignof(Types)...>()) char storage[max<sizeof(Types)...>()] {};
 	};
@@ -5,10 +5,17 @@ set(QACPI_INTERNAL_OPTIONS
 	-fno-omit-frame-pointer -mno-red-zone -Wframe-larger-than=4096
 )
 
+option(QACPI_THREADED_DISPATCH "Dispatch interpreter operands using computed goto (GCC/Clang only)" ON)
+option(QACPI_ATOMIC_REFCOUNT "Update object reference counts atomically so results can be shared between threads" OFF)
+option(QACPI_SLAB_ALLOCATOR "Serve small allocations from size class slabs instead of calling qacpi_os_malloc for each" OFF)
+
 add_library(qacpi_lib STATIC
 	${CMAKE_CURRENT_LIST_DIR}/src/interpreter.cpp
 	${CMAKE_CURRENT_LIST_DIR}/src/context.cpp
 	${CMAKE_CURRENT_LIST_DIR}/src/ops.cpp
+	${CMAKE_CURRENT_LIST_DIR}/src/verifier.cpp
+	${CMAKE_CURRENT_LIST_DIR}/src/purity.cpp
+	${CMAKE_CURRENT_LIST_DIR}/src/package_literal.cpp
 	${CMAKE_CURRENT_LIST_DIR}/src/string.cpp
 	${CMAKE_CURRENT_LIST_DIR}/src/buffer.cpp
 	${CMAKE_CURRENT_LIST_DIR}/src/ns.cpp
@@ -18,6 +25,7 @@ add_library(qacpi_lib STATIC
 	${CMAKE_CURRENT_LIST_DIR}/src/logger.cpp
 	${CMAKE_CURRENT_LIST_DIR}/src/op_region.cpp
 	${CMAKE_CURRENT_LIST_DIR}/src/resources.cpp
+	${CMAKE_CURRENT_LIST_DIR}/src/allocator.cpp
 	generated/osi.hpp
 )
 target_compile_options(qacpi_lib PRIVATE ${QACPI_INTERNAL_OPTIONS})
@@ -25,6 +33,17 @@ set_source_files_properties(${CMAKE_CURRENT_LIST_DIR}/src/interpreter.cpp
 	PROPERTIES COMPILE_FLAGS -O2)
 target_include_directories(qacpi_lib PRIVATE "${CMAKE_CURRENT_BINARY_DIR}/generated" "${CMAKE_CURRENT_LIST_DIR}/src")
 target_include_directories(qacpi_lib PUBLIC "${CMAKE_CURRENT_LIST_DIR}/include")
+if (QACPI_THREADED_DISPATCH AND CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+	target_compile_definitions(qacpi_lib PRIVATE QACPI_THREADED_DISPATCH)
+endif()
+# SharedPtr is in the public headers so users have to see the same definition
+if (QACPI_ATOMIC_REFCOUNT)
+	target_compile_definitions(qacpi_lib PUBLIC QACPI_ATOMIC_REFCOUNT)
+endif()
+# allocate is inline in allocator.hpp when the slab allocator is disabled
+if (QACPI_SLAB_ALLOCATOR)
+	target_compile_definitions(qacpi_lib PUBLIC QACPI_SLAB_ALLOCATOR)
+endif()
 
 add_library(qacpi_events_lib STATIC EXCLUDE_FROM_ALL
 	${CMAKE_CURRENT_LIST_DIR}/src/event.cpp
@@ -19,7 +19,11 @@ class SharedPtrPrinter:
 		self.value = value
 
 	def children(self):
-		yield "[ptr]", self.value["ptr"].dereference()
+		block = self.value["ptr"]
+		if int(block) == 0:
+			return
+		yield "[refs]", block["refs"]
+		yield "[value]", block["value"]
 
 
 def print_func(value):
@@ -0,0 +1,123 @@
+#include "qacpi/allocator.hpp"
+
+#ifdef QACPI_SLAB_ALLOCATOR
+
+namespace qacpi {
+	namespace {
+		constexpr size_t SLAB_SIZE = 0x1000;
+		constexpr size_t GRANULE = 16;
+		constexpr size_t MAX_SLAB_ALLOC = 512;
+
+		constexpr uint32_t CLASS_SIZES[] {16, 32, 48, 64, 96, 128, 192, 256, 384, 512};
+		constexpr size_t CLASS_COUNT = sizeof(CLASS_SIZES) / sizeof(*CLASS_SIZES);
+
+		// size class of each multiple of GRANULE up to MAX_SLAB_ALLOC
+		constexpr auto CLASS_OF = [] {
+			struct {
+				uint8_t value[MAX_SLAB_ALLOC / GRANULE + 1];
+			} res {};
+			uint8_t index = 0;
+			for (size_t i = 0; i <= MAX_SLAB_ALLOC / GRANULE; ++i) {
+				if (i * GRANULE > CLASS_SIZES[index]) {
+					++index;
+				}
+				res.value[i] = index;
+			}
+			return res;
+		}();
+
+		struct FreeEntry {
+			FreeEntry* next;
+		};
+
+		struct SizeClass {
+			FreeEntry* free_list;
+			bool lock;
+			SlabClassStats stats;
+		};
+
+		constinit SizeClass CLASSES[CLASS_COUNT] {};
+
+		void lock(SizeClass& size_class) {
+			while (__atomic_test_and_set(&size_class.lock, __ATOMIC_ACQUIRE)) {
+				while (__atomic_load_n(&size_class.lock, __ATOMIC_RELAXED)) {
+#if defined(__x86_64__) || defined(__i386__)
+					__builtin_ia32_pause();
+#endif
+				}
+			}
+		}
+
+		void unlock(SizeClass& size_class) {
+			__atomic_clear(&size_class.lock, __ATOMIC_RELEASE);
+		}
+
+		// the lock has to be held
+		bool refill(SizeClass& size_class, uint32_t size) {
+			auto* slab = static_cast<char*>(qacpi_os_malloc(SLAB_SIZE));
+			if (!slab) {
+				return false;
+			}
+
+			FreeEntry* head = size_class.free_list;
+			for (size_t offset = SLAB_SIZE / size * size; offset; offset -= size) {
+				auto* entry = reinterpret_cast<FreeEntry*>(slab + offset - size);
+				entry->next = head;
+				head = entry;
+			}
+			size_class.free_list = head;
+			++size_class.stats.slabs;
+			return true;
+		}
+	}
+
+	void* allocate(size_t size) {
+		if (size > MAX_SLAB_ALLOC) {
+			return qacpi_os_malloc(size);
+		}
+
+		auto& size_class = CLASSES[CLASS_OF.value[(size + GRANULE - 1) / GRANULE]];
+		lock(size_class);
+		if (!size_class.free_list &&
+			!refill(size_class, CLASS_SIZES[&size_class - CLASSES])) {
+			unlock(size_class);
+			return nullptr;
+		}
+
+		auto* entry = size_class.free_list;
+		size_class.free_list = entry->next;
+		++size_class.stats.allocations;
+		unlock(size_class);
+		return entry;
+	}
+
+	void deallocate(void* ptr, size_t size) {
+		if (!ptr) {
+			return;
+		}
+		else if (size > MAX_SLAB_ALLOC) {
+			qacpi_os_free(ptr, size);
+			return;
+		}
+
+		auto& size_class = CLASSES[CLASS_OF.value[(size + GRANULE - 1) / GRANULE]];
+		auto* entry = static_cast<FreeEntry*>(ptr);
+		lock(size_class);
+		entry->next = size_class.free_list;
+		size_class.free_list = entry;
+		++size_class.stats.frees;
+		unlock(size_class);
+	}
+
+	size_t get_slab_stats(SlabClassStats* stats, size_t count) {
+		for (size_t i = 0; i < count && i < CLASS_COUNT; ++i) {
+			lock(CLASSES[i]);
+			stats[i] = CLASSES[i].stats;
+			unlock(CLASSES[i]);
+			stats[i].size = CLASS_SIZES[i];
+		}
+		return CLASS_COUNT;
+	}
+}
+
+#endif
@@ -38,6 +38,7 @@ enum {
 	FatalOp = 0x32,
 	TimerOp = 0x33,
 	RootChar = '\\',
+	ExtOpPrefix = 0x5B,
 	ParentPrefixChar = '^',
 	Local0Op = 0x60,
 	Local1Op = 0x61,
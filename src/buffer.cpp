@@ -11,13 +11,20 @@ namespace qacpi {
 		return *this;
 	}
 
+	uint8_t* Buffer::alloc(uint32_t size) {
+		if (size <= sizeof(_data->inline_storage)) {
+			return _data->inline_storage;
+		}
+		return static_cast<uint8_t*>(allocate(size));
+	}
+
 	bool Buffer::init(const void* new_data, uint32_t new_size) {
 		if (!_data) {
 			return false;
 		}
 
 		if (new_size) {
-			auto* ptr = static_cast<uint8_t*>(qacpi_os_malloc(new_size));
+			auto* ptr = alloc(new_size);
 			if (!ptr) {
 				return false;
 			}
@@ -34,7 +41,7 @@ namespace qacpi {
 		}
 
 		if (new_size) {
-			auto* ptr = static_cast<uint8_t*>(qacpi_os_malloc(new_size));
+			auto* ptr = alloc(new_size);
 			if (!ptr) {
 				return false;
 			}
@@ -46,12 +53,43 @@ namespace qacpi {
 	}
 
 	bool Buffer::clone(const Buffer& other) {
-		return init(other._data->data, other._data->size);
+		_data = other._data;
+		return true;
+	}
+
+	bool Buffer::unshare() {
+		if (_data.is_unique()) {
+			return true;
+		}
+
+		Buffer copy;
+		if (!copy.init(_data->data, _data->size)) {
+			return false;
+		}
+		_data = move(copy._data);
+		return true;
+	}
+
+	uint8_t* Buffer::leak() {
+		if (!unshare()) {
+			return nullptr;
+		}
+
+		auto ptr = _data->data;
+		if (ptr == _data->inline_storage) {
+			ptr = static_cast<uint8_t*>(allocate(_data->size));
+			if (ptr) {
+				memcpy(ptr, _data->inline_storage, _data->size);
+			}
+		}
+		_data->data = nullptr;
+		_data->size = 0;
+		return ptr;
 	}
 
 	Buffer::Data::~Data() {
-		if (data) {
-			qacpi_os_free(data, size);
+		if (data && data != inline_storage) {
+			deallocate(data, size);
 		}
 	}
 
@@ -65,7 +103,7 @@ namespace qacpi {
 		}
 
 		if (new_size) {
-			auto* ptr = static_cast<ObjectRef*>(qacpi_os_malloc(new_size * sizeof(ObjectRef)));
+			auto* ptr = static_cast<ObjectRef*>(allocate(new_size * sizeof(ObjectRef)));
 			if (!ptr) {
 				return false;
 			}
@@ -78,13 +116,94 @@ namespace qacpi {
 		return true;
 	}
 
+	bool Package::init_integers(uint32_t new_size) {
+		if (!data) {
+			return false;
+		}
+
+		if (new_size) {
+			auto* ptr = static_cast<uint64_t*>(allocate(new_size * sizeof(uint64_t)));
+			if (!ptr) {
+				return false;
+			}
+			data->integers = ptr;
+			data->element_count = new_size;
+		}
+		return true;
+	}
+
+	bool Package::box() {
+		if (!materialize()) {
+			return false;
+		}
+		if (!data->integers) {
+			return true;
+		}
+
+		auto count = data->element_count;
+		auto* ptr = static_cast<ObjectRef*>(allocate(count * sizeof(ObjectRef)));
+		if (!ptr) {
+			return false;
+		}
+		for (uint32_t i = 0; i < count; ++i) {
+			construct<ObjectRef>(&ptr[i], ObjectRef {});
+			if (!ptr[i]) {
+				for (uint32_t j = 0; j <= i; ++j) {
+					ptr[j].~SharedPtr();
+				}
+				deallocate(ptr, count * sizeof(ObjectRef));
+				return false;
+			}
+			ptr[i]->data = data->integers[i];
+		}
+
+		deallocate(data->integers, count * sizeof(uint64_t));
+		data->integers = nullptr;
+		data->elements = ptr;
+		return true;
+	}
+
 	bool Package::clone(const Package& other) {
+		// an element that is referenced elsewhere could be modified through that reference
+		for (uint32_t i = 0; other.data->elements && i < other.data->element_count; ++i) {
+			if (!other.data->elements[i].is_unique()) {
+				return copy(other);
+			}
+		}
+
+		data = other.data;
+		return true;
+	}
+
+	bool Package::unshare() {
+		if (data.is_unique()) {
+			return true;
+		}
+
+		Package res;
+		if (!res.copy(*this)) {
+			return false;
+		}
+		data = move(res.data);
+		return true;
+	}
+
+	bool Package::copy(const Package& other) {
 		if (!data) {
 			return false;
 		}
 
-		if (other.data->element_count) {
-			auto* ptr = static_cast<ObjectRef*>(qacpi_os_malloc(other.data->element_count * sizeof(ObjectRef)));
+		if (other.data->aml) {
+			init_lazy(other.data->aml, other.data->aml_size, other.data->element_count);
+		}
+		else if (other.data->integers) {
+			if (!init_integers(other.data->element_count)) {
+				return false;
+			}
+			memcpy(data->integers, other.data->integers, other.data->element_count * sizeof(uint64_t));
+		}
+		else if (other.data->element_count) {
+			auto* ptr = static_cast<ObjectRef*>(allocate(other.data->element_count * sizeof(ObjectRef)));
 			if (!ptr) {
 				return false;
 			}
@@ -94,7 +213,7 @@ namespace qacpi {
 					for (uint32_t j = 0; j <= i; ++j) {
 						ptr[j].~SharedPtr();
 					}
-					qacpi_os_free(ptr, other.data->element_count * sizeof(ObjectRef));
+					deallocate(ptr, other.data->element_count * sizeof(ObjectRef));
 					return false;
 				}
 				ptr[i]->node = other.data->elements[i]->node;
@@ -110,7 +229,10 @@ namespace qacpi {
 			for (uint32_t i = 0; i < element_count; ++i) {
 				elements[i].~SharedPtr();
 			}
-			qacpi_os_free(elements, element_count * sizeof(ObjectRef));
+			deallocate(elements, element_count * sizeof(ObjectRef));
+		}
+		else if (integers) {
+			deallocate(integers, element_count * sizeof(uint64_t));
 		}
 	}
 }
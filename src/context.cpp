@@ -1,5 +1,7 @@
 #include "qacpi/context.hpp"
 #include "interpreter.hpp"
+#include "verifier.hpp"
+#include "purity.hpp"
 #include "qacpi/ns.hpp"
 #include "logger.hpp"
 #include "osi.hpp"
@@ -312,17 +314,38 @@ Status Context::init(uintptr_t rsdp_phys, LogLevel new_log_level) {
 }
 
 Context::~Context() {
+	while (free_interpreters) {
+		auto* next = free_interpreters->next_free;
+		free_interpreters->~Interpreter();
+		deallocate(free_interpreters, sizeof(Interpreter));
+		free_interpreters = next;
+	}
+
+	if (constants) {
+		for (uint32_t i = 0; i < CONSTANT_COUNT; ++i) {
+			constants[i].~ObjectRef();
+		}
+		deallocate(constants, CONSTANT_COUNT * sizeof(ObjectRef));
+	}
+
+	if (method_bodies) {
+		for (uint32_t i = 0; i < method_body_cap; ++i) {
+			method_bodies[i].~MethodBody();
+		}
+		deallocate(method_bodies, method_body_cap * sizeof(MethodBody));
+	}
+
 	auto* node = all_nodes;
 	while (node) {
 		auto* next = node->link;
 		node->~NamespaceNode();
-		qacpi_os_free(node, sizeof(NamespaceNode));
+		deallocate(node, sizeof(NamespaceNode));
 		node = next;
 	}
 
 	for (auto& table : tables) {
 		if (table.table.allocated_in_buffer) {
-			qacpi_os_free(table.table.data, table.table.size);
+			deallocate(table.table.data, table.table.size);
 		}
 		else {
 			if (table.table.data) {
@@ -450,17 +473,186 @@ Status Context::load_namespace() {
 	return Status::Success;
 }
 
+Interpreter* Context::get_interpreter() {
+	auto* interp = free_interpreters;
+	if (interp) {
+		free_interpreters = interp->next_free;
+		interp->next_free = nullptr;
+	}
+	else {
+		auto* mem = allocate(sizeof(Interpreter));
+		if (!mem) {
+			return nullptr;
+		}
+		interp = construct<Interpreter>(mem, this);
+	}
+
+	interp->int_size = revision >= 2 ? 8 : 4;
+	return interp;
+}
+
+void Context::put_interpreter(Interpreter* interp) {
+	interp->reset();
+	interp->next_free = free_interpreters;
+	free_interpreters = interp;
+}
+
+ObjectRef Context::get_constant(uint32_t index) {
+	if (!constants) {
+		constants = static_cast<ObjectRef*>(allocate(CONSTANT_COUNT * sizeof(ObjectRef)));
+		if (!constants) {
+			return ObjectRef::empty();
+		}
+		for (uint32_t i = 0; i < CONSTANT_COUNT; ++i) {
+			construct<ObjectRef>(&constants[i], ObjectRef::empty());
+		}
+	}
+
+	auto& constant = constants[index];
+	if (!constant) {
+		constant = ObjectRef {};
+		if (!constant) {
+			return ObjectRef::empty();
+		}
+
+		if (index == CONSTANT_NULL_TARGET) {
+			constant->data = NullTarget {};
+		}
+		else if (index == CONSTANT_ONES) {
+			constant->data = uint64_t {0xFFFFFFFFFFFFFFFF};
+		}
+		else {
+			constant->data = uint64_t {index};
+		}
+	}
+
+	return constant;
+}
+
+bool Context::is_constant(const ObjectRef& obj) const {
+	if (!constants || !obj) {
+		return false;
+	}
+
+	const ObjectRef* constant;
+	if (auto value = obj->get<uint64_t>()) {
+		constant = *value < CONSTANT_ONES ? &constants[*value] : &constants[CONSTANT_ONES];
+	}
+	else if (obj->get<NullTarget>()) {
+		constant = &constants[CONSTANT_NULL_TARGET];
+	}
+	else {
+		return false;
+	}
+
+	return *constant && &**constant == &*obj;
+}
+
+static uint64_t hash_bytes(const uint8_t* data, uint32_t size) {
+	// fnv-1a
+	uint64_t hash = 0xCBF29CE484222325;
+	for (uint32_t i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 0x100000001B3;
+	}
+	return hash;
+}
+
+SharedPtr<MethodCache> Context::share_method_body(const uint8_t* aml, uint32_t size, bool& verified) {
+	auto hash = hash_bytes(aml, size);
+
+	if (method_body_cap) {
+		auto mask = method_body_cap - 1;
+		for (auto i = static_cast<uint32_t>(hash) & mask;; i = (i + 1) & mask) {
+			auto& body = method_bodies[i];
+			if (!body.cache) {
+				break;
+			}
+			if (body.hash == hash && body.aml && body.size == size &&
+				(body.aml == aml || memcmp(body.aml, aml, size) == 0)) {
+				verified |= body.verified;
+				return body.cache;
+			}
+		}
+	}
+
+	if (!verified) {
+		verified = verify_aml(aml, size);
+	}
+
+	// keep the load factor at or below 3/4
+	if ((method_body_count + 1) * 4 > method_body_cap * 3) {
+		uint32_t new_cap = method_body_cap ? method_body_cap * 2 : 64;
+		auto* new_bodies = static_cast<MethodBody*>(allocate(new_cap * sizeof(MethodBody)));
+		if (!new_bodies) {
+			return SharedPtr<MethodCache>::empty();
+		}
+		for (uint32_t i = 0; i < new_cap; ++i) {
+			construct<MethodBody>(&new_bodies[i], MethodBody {
+				.hash = 0,
+				.aml = nullptr,
+				.size = 0,
+				.verified = false,
+				.cache {SharedPtr<MethodCache>::empty()}
+			});
+		}
+
+		for (uint32_t i = 0; i < method_body_cap; ++i) {
+			auto& body = method_bodies[i];
+			if (body.cache) {
+				auto j = static_cast<uint32_t>(body.hash) & (new_cap - 1);
+				while (new_bodies[j].cache) {
+					j = (j + 1) & (new_cap - 1);
+				}
+				new_bodies[j] = move(body);
+			}
+			body.~MethodBody();
+		}
+		if (method_bodies) {
+			deallocate(method_bodies, method_body_cap * sizeof(MethodBody));
+		}
+		method_bodies = new_bodies;
+		method_body_cap = new_cap;
+	}
+
+	SharedPtr<MethodCache> cache {};
+	if (!cache) {
+		return SharedPtr<MethodCache>::empty();
+	}
+
+	auto i = static_cast<uint32_t>(hash) & (method_body_cap - 1);
+	while (method_bodies[i].cache) {
+		i = (i + 1) & (method_body_cap - 1);
+	}
+	method_bodies[i] = {
+		.hash = hash,
+		.aml = aml,
+		.size = size,
+		.verified = verified,
+		.cache {cache}
+	};
+	++method_body_count;
+	return cache;
+}
+
+void Context::forget_method_bodies(const uint8_t* aml, uint32_t size) {
+	for (uint32_t i = 0; i < method_body_cap; ++i) {
+		auto& body = method_bodies[i];
+		if (body.aml >= aml && body.aml < aml + size) {
+			body.aml = nullptr;
+		}
+	}
+}
+
 Status Context::load_table(const uint8_t* aml, uint32_t size) {
-	auto* mem = qacpi_os_malloc(sizeof(Interpreter));
-	if (!mem) {
+	auto* interp = get_interpreter();
+	if (!interp) {
 		return Status::NoMemory;
 	}
-	auto* interp = construct<Interpreter>(mem, this, static_cast<uint8_t>(revision >= 2 ? 8 : 4));
 
-	auto status = interp->execute(aml, size);
+	auto status = interp->execute(aml, size, verify_aml(aml, size));
 
-	interp->~Interpreter();
-	qacpi_os_free(mem, sizeof(Interpreter));
+	put_interpreter(interp);
 
 	return status;
 }
@@ -475,17 +667,57 @@ Status Context::evaluate(StringView name, ObjectRef& res, ObjectRef* args, int a
 		return Status::InternalError;
 	}
 	if (node->object->get<Method>()) {
-		auto* mem = qacpi_os_malloc(sizeof(Interpreter));
-		if (!mem) {
+		auto* interp = get_interpreter();
+		if (!interp) {
 			return Status::NoMemory;
 		}
 
-		auto* interp = construct<Interpreter>(mem, this, static_cast<uint8_t>(revision >= 2 ? 8 : 4));
+		auto status = interp->invoke_method(node, res, args, arg_count);
+
+		put_interpreter(interp);
+
+		return status;
+	}
+	else {
+		res = node->object;
+		return Status::Success;
+	}
+}
+
+Status Context::start_evaluation(
+	StringView name,
+	ObjectRef& res,
+	const EvalBudget& budget,
+	bool async,
+	Interpreter*& eval,
+	ObjectRef* args,
+	int arg_count) {
+	eval = nullptr;
 
+	auto* node = create_or_find_node(root, nullptr, name, SearchFlags::Search);
+	if (!node) {
+		return Status::NotFound;
+	}
+	if (!node->object) {
+		LOG << "qacpi internal error in Context::start_evaluation, node->object is null" << endlog;
+		return Status::InternalError;
+	}
+	if (node->object->get<Method>()) {
+		auto* interp = get_interpreter();
+		if (!interp) {
+			return Status::NoMemory;
+		}
+
+		interp->set_budget(budget);
+		interp->async = async;
+		interp->suspendable = true;
 		auto status = interp->invoke_method(node, res, args, arg_count);
+		if (status == Status::Suspended) {
+			eval = interp;
+			return status;
+		}
 
-		interp->~Interpreter();
-		qacpi_os_free(mem, sizeof(Interpreter));
+		put_interpreter(interp);
 
 		return status;
 	}
@@ -495,6 +727,54 @@ Status Context::evaluate(StringView name, ObjectRef& res, ObjectRef* args, int a
 	}
 }
 
+Status Context::evaluate_budgeted(
+	StringView name,
+	ObjectRef& res,
+	const EvalBudget& budget,
+	Interpreter*& eval,
+	ObjectRef* args,
+	int arg_count) {
+	return start_evaluation(name, res, budget, false, eval, args, arg_count);
+}
+
+Status Context::resume(Interpreter* eval, ObjectRef& res, const EvalBudget& budget) {
+	auto status = eval->resume(res, budget);
+	if (status != Status::Suspended) {
+		put_interpreter(eval);
+	}
+	return status;
+}
+
+Status Context::evaluate_async(
+	StringView name,
+	ObjectRef& res,
+	const EvalBudget& budget,
+	Interpreter*& eval,
+	WaitCondition& wait,
+	ObjectRef* args,
+	int arg_count) {
+	auto status = start_evaluation(name, res, budget, true, eval, args, arg_count);
+	if (status == Status::Suspended) {
+		wait = eval->wait;
+	}
+	return status;
+}
+
+Status Context::resume_async(Interpreter* eval, ObjectRef& res, const EvalBudget& budget, WaitCondition& wait) {
+	auto status = eval->resume(res, budget);
+	if (status == Status::Suspended) {
+		wait = eval->wait;
+	}
+	else {
+		put_interpreter(eval);
+	}
+	return status;
+}
+
+void Context::abort_evaluation(Interpreter* eval) {
+	put_interpreter(eval);
+}
+
 Status Context::evaluate(NamespaceNode* node, StringView name, ObjectRef& res, ObjectRef* args, int arg_count) {
 	if (!node) {
 		return Status::NotFound;
@@ -510,16 +790,14 @@ Status Context::evaluate(NamespaceNode* node, StringView name, ObjectRef& res, O
 		return Status::InternalError;
 	}
 	if (node->object->get<Method>()) {
-		auto* mem = qacpi_os_malloc(sizeof(Interpreter));
-		if (!mem) {
+		auto* interp = get_interpreter();
+		if (!interp) {
 			return Status::NoMemory;
 		}
-		auto* interp = construct<Interpreter>(mem, this, static_cast<uint8_t>(revision >= 2 ? 8 : 4));
 
 		auto status = interp->invoke_method(node, res, args, arg_count);
 
-		interp->~Interpreter();
-		qacpi_os_free(mem, sizeof(Interpreter));
+		put_interpreter(interp);
 
 		return status;
 	}
@@ -600,6 +878,9 @@ Status Context::evaluate_buffer(StringView name, Buffer& res, ObjectRef* args, i
 	}
 	else {
 		res = move(obj->get_unsafe<Buffer>());
+		if (!res.unshare()) {
+			return Status::NoMemory;
+		}
 	}
 	return Status::Success;
 }
@@ -615,10 +896,69 @@ Status Context::evaluate_buffer(NamespaceNode* node, StringView name, Buffer& re
 	}
 	else {
 		res = move(obj->get_unsafe<Buffer>());
+		if (!res.unshare()) {
+			return Status::NoMemory;
+		}
+	}
+	return Status::Success;
+}
+
+Status Context::evaluate_batch(const EvalRequest* requests, ObjectRef* results, Status* statuses, size_t count) {
+	Interpreter* interp = nullptr;
+
+	for (size_t i = 0; i < count; ++i) {
+		auto& req = requests[i];
+		auto* node = req.node ? req.node->get_child(req.name) : nullptr;
+		if (!node) {
+			statuses[i] = Status::NotFound;
+			continue;
+		}
+
+		if (!node->object) {
+			LOG << "qacpi internal error in Context::evaluate_batch, node->object is null" << endlog;
+			statuses[i] = Status::InternalError;
+			continue;
+		}
+		if (!node->object->get<Method>()) {
+			results[i] = node->object;
+			statuses[i] = Status::Success;
+			continue;
+		}
+
+		if (!interp) {
+			interp = get_interpreter();
+			if (!interp) {
+				for (; i < count; ++i) {
+					statuses[i] = Status::NoMemory;
+				}
+				return Status::NoMemory;
+			}
+		}
+		else {
+			interp->reset();
+		}
+
+		statuses[i] = interp->invoke_method(node, results[i], req.args, req.arg_count);
+	}
+
+	if (interp) {
+		put_interpreter(interp);
 	}
 	return Status::Success;
 }
 
+bool Context::is_pure(NamespaceNode* node) {
+	if (!node || !node->object) {
+		return false;
+	}
+	if (!node->object->get<Method>()) {
+		return true;
+	}
+
+	auto purity = analyze_purity(*this, node);
+	return purity == MethodPurity::Pure || purity == MethodPurity::Constant;
+}
+
 static constexpr uint32_t DEVICE_PRESENT = 1 << 0;
 static constexpr uint32_t DEVICE_FUNCTIONING = 1 << 3;
 
@@ -820,14 +1160,19 @@ Status Context::discover_nodes(
 				cid_id = EisaId::decode(*integer);
 			}
 			else if (auto pkg = res->get<Package>()) {
+				if (!pkg->materialize()) {
+					return Status::NoMemory;
+				}
 				for (uint32_t i = 0; i < pkg->data->element_count; ++i) {
-					auto& element = pkg->data->elements[i];
-					if ((str = element->get<String>())) {
+					if (pkg->data->integers) {
+						cid_id = EisaId::decode(pkg->data->integers[i]);
+					}
+					else if ((str = pkg->data->elements[i]->get<String>())) {
 						if (str->size() >= 6) {
 							cid_id = EisaId {str->data(), str->size()};
 						}
 					}
-					else if ((integer = element->get<uint64_t>())) {
+					else if ((integer = pkg->data->elements[i]->get<uint64_t>())) {
 						cid_id = EisaId::decode(*integer);
 					}
 
@@ -921,7 +1266,11 @@ Status Context::discover_nodes(
 					}
 				}
 				else if (auto pkg = res->get<Package>()) {
-					for (uint32_t i = 0; i < pkg->data->element_count; ++i) {
+					if (!pkg->materialize()) {
+						return Status::NoMemory;
+					}
+					// packed packages only contain integers
+					for (uint32_t i = 0; !pkg->data->integers && i < pkg->data->element_count; ++i) {
 						auto& element = pkg->data->elements[i];
 						if ((str = element->get<String>())) {
 							for (size_t j = 0; j < id_count; ++j) {
@@ -1066,25 +1415,10 @@ NamespaceNode* Context::create_or_find_node(NamespaceNode* start, void* method_f
 			goto again;
 		}
 		else if (flags == SearchFlags::Create) {
-			auto* new_node = NamespaceNode::create(segment);
+			auto* new_node = create_child(node, segment, method_frame);
 			if (!new_node) {
 				return nullptr;
 			}
-			if (!node->add_child(new_node)) {
-				new_node->~NamespaceNode();
-				qacpi_os_free(new_node, sizeof(NamespaceNode));
-				return nullptr;
-			}
-
-			if (method_frame) {
-				auto& frame = *static_cast<Interpreter::MethodFrame*>(method_frame);
-				new_node->link = frame.node_link;
-				frame.node_link = new_node;
-			}
-			else {
-				new_node->link = all_nodes;
-				all_nodes = new_node;
-			}
 
 			if (!size) {
 				return new_node;
@@ -1096,9 +1430,116 @@ NamespaceNode* Context::create_or_find_node(NamespaceNode* start, void* method_f
 	}
 }
 
+NamespaceNode* Context::create_or_find_node(NamespaceNode* start, void* method_frame, const NamePath& path, SearchFlags flags) {
+	NamespaceNode* node;
+	if (path.absolute) {
+		node = root;
+	}
+	else {
+		node = start;
+		for (uint32_t i = 0; i < path.parent_count; ++i) {
+			if (!node->parent) {
+				return nullptr;
+			}
+			node = node->parent;
+		}
+	}
+
+	if (!path.segment_count) {
+		return path.absolute || path.parent_count ? node : nullptr;
+	}
+
+	auto* segment = reinterpret_cast<const char*>(path.segments);
+	for (uint32_t seg = 0; seg < path.segment_count; ++seg, segment += 4) {
+	again:
+		bool found = false;
+		for (size_t i = 0; i < node->child_count; ++i) {
+			if (name_cmp(node->children[i]->_name, segment)) {
+				node = node->children[i];
+				found = true;
+				break;
+			}
+		}
+
+		if (found) {
+			continue;
+		}
+		else if (flags == SearchFlags::OnlyChildren) {
+			return nullptr;
+		}
+		else if (flags == SearchFlags::Search) {
+			node = node->parent;
+			if (!node) {
+				return nullptr;
+			}
+			goto again;
+		}
+		else if (flags == SearchFlags::Create) {
+			char name[5] {segment[0], segment[1], segment[2], segment[3], 0};
+			node = create_child(node, name, method_frame);
+			if (!node) {
+				return nullptr;
+			}
+		}
+	}
+
+	return node;
+}
+
+NamespaceNode* Context::create_child(NamespaceNode* parent, const char* segment, void* method_frame) {
+	auto* new_node = NamespaceNode::create(segment);
+	if (!new_node) {
+		return nullptr;
+	}
+	if (!parent->add_child(new_node)) {
+		new_node->~NamespaceNode();
+		deallocate(new_node, sizeof(NamespaceNode));
+		return nullptr;
+	}
+
+	if (method_frame) {
+		auto& frame = *static_cast<Interpreter::MethodFrame*>(method_frame);
+		new_node->link = frame.node_link;
+		frame.node_link = new_node;
+		frame.context = this;
+	}
+	else {
+		new_node->link = all_nodes;
+		all_nodes = new_node;
+	}
+	++ns_generation;
+
+	return new_node;
+}
+
+bool Context::get_pkg_int(ObjectRef& pkg_obj, uint32_t index, uint64_t& res) {
+	Package* pkg;
+	if (!pkg_obj || !(pkg = pkg_obj->get<Package>()) || index >= pkg->data->element_count ||
+		!pkg->materialize()) {
+		return false;
+	}
+
+	if (pkg->data->integers) {
+		res = pkg->data->integers[index];
+		return true;
+	}
+	else if (auto integer = pkg->data->elements[index]->get<uint64_t>()) {
+		res = *integer;
+		return true;
+	}
+
+	auto elem = get_pkg_element(pkg_obj, index);
+	if (!elem || !elem->get<uint64_t>()) {
+		return false;
+	}
+	res = elem->get_unsafe<uint64_t>();
+	return true;
+}
+
 ObjectRef Context::get_pkg_element(ObjectRef& pkg_obj, uint32_t index) {
 	Package* pkg;
-	if (!pkg_obj || !(pkg = pkg_obj->get<Package>()) || index >= pkg->data->element_count) {
+	if (!pkg_obj || !(pkg = pkg_obj->get<Package>()) || index >= pkg->data->element_count ||
+		!pkg->unshare() || !pkg->box()) {
 		return ObjectRef::empty();
 	}
 
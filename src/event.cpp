@@ -344,7 +344,7 @@ namespace qacpi::events {
 			return Status::NoMemory;
 		}
 
-		auto* ptr = qacpi_os_malloc(sizeof(Inner));
+		auto* ptr = allocate(sizeof(Inner));
 		if (!ptr) {
 			return Status::NoMemory;
 		}
@@ -426,7 +426,7 @@ namespace qacpi::events {
 		status = qacpi_os_install_sci_handler(fadt->sci_int, qacpi_on_sci, this, &inner->sci_handle);
 		if (status != Status::Success) {
 			inner->~Inner();
-			qacpi_os_free(inner, sizeof(Inner));
+			deallocate(inner, sizeof(Inner));
 			inner = nullptr;
 			return status;
 		}
@@ -453,7 +453,7 @@ namespace qacpi::events {
 			qacpi_os_uninstall_sci_handler(inner->sci_irq, inner->sci_handle);
 
 			inner->~Inner();
-			qacpi_os_free(inner, sizeof(Inner));
+			deallocate(inner, sizeof(Inner));
 		}
 	}
 
@@ -699,7 +699,7 @@ namespace qacpi::events {
 		qacpi::NamespaceNode* node,
 		void (*handler)(void* arg, NamespaceNode* node, uint64_t value),
 		void* arg) {
-		auto* ptr = qacpi_os_malloc(sizeof(NotifyHandler));
+		auto* ptr = allocate(sizeof(NotifyHandler));
 		if (!ptr) {
 			return Status::NoMemory;
 		}
@@ -731,7 +731,7 @@ namespace qacpi::events {
 					ptr->next->prev = ptr->prev;
 				}
 
-				qacpi_os_free(ptr, sizeof(NotifyHandler));
+				deallocate(ptr, sizeof(NotifyHandler));
 				break;
 			}
 		}
@@ -762,11 +762,10 @@ namespace qacpi::events {
 				return Status::InvalidAml;
 			case 1:
 			{
-				auto obj = ctx.get_pkg_element(ret, 0);
-				if (!obj->get<uint64_t>()) {
+				uint64_t value;
+				if (!ctx.get_pkg_int(ret, 0, value)) {
 					return Status::InvalidAml;
 				}
-				auto value = obj->get_unsafe<uint64_t>();
 
 				slp_typa = value;
 				slp_typb = value >> 8;
@@ -774,14 +773,14 @@ namespace qacpi::events {
 			}
 			default:
 			{
-				auto first_obj = ctx.get_pkg_element(ret, 0);
-				auto second_obj = ctx.get_pkg_element(ret, 1);
-				if (!first_obj->get<uint64_t>() || !second_obj->get<uint64_t>()) {
+				uint64_t first;
+				uint64_t second;
+				if (!ctx.get_pkg_int(ret, 0, first) || !ctx.get_pkg_int(ret, 1, second)) {
 					return Status::InvalidAml;
 				}
 
-				slp_typa = first_obj->get_unsafe<uint64_t>();
-				slp_typb = second_obj->get_unsafe<uint64_t>();
+				slp_typa = first;
+				slp_typb = second;
 				break;
 			}
 		}
@@ -1,5 +1,8 @@
 #include "interpreter.hpp"
 #include "aml_ops.hpp"
+#include "verifier.hpp"
+#include "purity.hpp"
+#include "package_literal.hpp"
 #include "qacpi/ns.hpp"
 #include "qacpi/tables.hpp"
 #include "qacpi/resources.hpp"
@@ -8,7 +11,7 @@
 
 using namespace qacpi;
 
-Status Interpreter::execute(const uint8_t* aml, uint32_t size) {
+Status Interpreter::execute(const uint8_t* aml, uint32_t size, bool verified) {
 	auto* frame = frames.push();
 	if (!frame) {
 		return Status::NoMemory;
@@ -20,6 +23,7 @@ Status Interpreter::execute(const uint8_t* aml, uint32_t size) {
 	frame->objects_at_start = objects.size();
 	frame->need_result = false;
 	frame->is_method = false;
+	frame->verified = verified;
 	frame->type = Frame::Scope;
 
 	return parse();
@@ -36,17 +40,37 @@ static constexpr OpBlock TERM_ARG_BLOCK {
 
 #define CHECK_EOF if (frame.ptr == frame.end) return Status::UnexpectedEof
 #define CHECK_EOF_NUM(num) if (frame.ptr + (num) > frame.end) return Status::UnexpectedEof
+// operands of code accepted by verify_aml are known to be within bounds, the rest of a
+// PkgLength region still has to be checked with CHECK_EOF_NUM as a name before it can be
+// a method call that takes more arguments than the region contains
+#define CHECK_OPERAND_EOF if (!frame.verified) CHECK_EOF
+#define CHECK_OPERAND_EOF_NUM(num) if (!frame.verified) CHECK_EOF_NUM(num)
 
 static bool is_name_char(uint8_t c) {
-	return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
-		c == '\\' || c == '^' || c == '_' || c == ParentPrefixChar || c == RootChar ||
-		c == DualNamePrefix || c == MultiNamePrefix;
+	return BYTE_CLASSES[c] == ByteClass::NameChar;
 }
 
 NamespaceNode* Interpreter::create_or_get_node(StringView name, Context::SearchFlags flags) {
 	return context->create_or_find_node(current_scope, !method_frames.is_empty() ? &method_frames.back() : nullptr, name, flags);
 }
 
+NamespaceNode* Interpreter::create_or_get_node(const NamePath& path, Context::SearchFlags flags) {
+	return context->create_or_find_node(current_scope, !method_frames.is_empty() ? &method_frames.back() : nullptr, path, flags);
+}
+
+// re-evaluates the predicate of a running While loop, frame.start points to it
+static constexpr OpBlock WHILE_PREDICATE_BLOCK {
+	.op_count = 2,
+	.ops {
+		Op::TermArg,
+		Op::CallHandler
+	},
+	.handler = OpHandler::While
+};
+
+// the loop timeout is only checked every this many iterations unless the body blocked
+static constexpr uint32_t LOOP_TIMER_INTERVAL = 64;
+
 static constexpr OpBlock CALL_BLOCK {
 	.op_count = 2,
 	.ops {
@@ -56,26 +80,6 @@ static constexpr OpBlock CALL_BLOCK {
 	.handler = OpHandler::Call
 };
 
-Status Interpreter::resolve_object(ObjectRef& object) {
-	if (auto unresolved = object->get<String>(); unresolved && unresolved->is_path()) {
-		auto* node = create_or_get_node(*unresolved, Context::SearchFlags::Search);
-		if (!node) {
-			return Status::NotFound;
-		}
-		else if (!node->object) {
-			LOG << "qacpi: internal error in resolve_object, node->object is null" << endlog;
-			return Status::InternalError;
-		}
-
-		object = node->object;
-	}
-	else {
-		__builtin_trap();
-	}
-
-	return Status::Success;
-}
-
 Status Interpreter::invoke_method(NamespaceNode* node, ObjectRef& res, ObjectRef* args, int arg_count) {
 	auto& obj = node->object;
 	if (auto method = obj->get<Method>()) {
@@ -83,13 +87,17 @@ Status Interpreter::invoke_method(NamespaceNode* node, ObjectRef& res, ObjectRef
 			return Status::InvalidArgs;
 		}
 
-		if (method->serialized) {
-			if (method->mutex->is_owned_by_thread()) {
-				++method->mutex->recursion;
-			}
-			else {
-				method->mutex->lock(0xFFFF);
+		if (method->purity == MethodPurity::Unknown) {
+			analyze_purity(*context, node);
+		}
+		if (method->memo) {
+			ObjectRef copy;
+			if (!copy || !method->memo->data.clone(copy->data)) {
+				return Status::NoMemory;
 			}
+			copy->node = node->parent;
+			res = move(copy);
+			return Status::Success;
 		}
 
 		auto* new_frame = frames.push();
@@ -103,6 +111,7 @@ Status Interpreter::invoke_method(NamespaceNode* node, ObjectRef& res, ObjectRef
 		new_frame->parent_scope = current_scope;
 		new_frame->need_result = true;
 		new_frame->is_method = true;
+		new_frame->verified = method->verified;
 		new_frame->type = Frame::Scope;
 
 		current_scope = node;
@@ -113,7 +122,7 @@ Status Interpreter::invoke_method(NamespaceNode* node, ObjectRef& res, ObjectRef
 		}
 
 		method_frame->node_link = nullptr;
-		method_frame->serialize_mutex = method->mutex;
+		use_method_cache(*method_frame, *method);
 		for (int i = 0; i < method->arg_count; ++i) {
 			ObjectRef arg;
 			if (!arg) {
@@ -122,28 +131,164 @@ Status Interpreter::invoke_method(NamespaceNode* node, ObjectRef& res, ObjectRef
 
 			auto copy = args[i];
 			arg->data = Ref {.type = Ref::Arg, .inner {move(copy)}};
-			method_frame->args[i] = move(arg);
+			method_frame->arg(i) = move(arg);
 		}
 
-		auto status = parse();
+		eval_node = node;
+		if (method->serialized) {
+			if (auto status = lock_serialized(*method->mutex); status != Status::Success) {
+				serialize_pending = status == Status::Suspended;
+				return finish_method(res, status);
+			}
+			method_frame->serialize_mutex = method->mutex;
+		}
+		return finish_method(res, parse());
+	}
+	else {
+		return Status::InvalidArgs;
+	}
+}
 
-		if (status == Status::Success && !objects.is_empty()) {
-			res = pop_and_unwrap_obj();
+Status Interpreter::finish_method(ObjectRef& res, Status status) {
+	if (status == Status::Suspended) {
+		suspend_time = qacpi_os_timer() * 100;
+		return status;
+	}
 
-			if (!res->node) {
-				res->node = node->parent;
+	if (status == Status::Success && !objects.is_empty()) {
+		res = pop_and_unwrap_obj();
+		if (context->is_constant(res)) {
+			ObjectRef copy;
+			if (!copy || !res->data.clone(copy->data)) {
+				return Status::NoMemory;
 			}
+			res = move(copy);
 		}
-		else {
-			if (res) {
-				res->data = Uninitialized {};
+
+		if (!res->node) {
+			res->node = eval_node->parent;
+		}
+
+		auto& method = eval_node->object->get_unsafe<Method>();
+		if (method.purity == MethodPurity::Constant && !method.memo) {
+			ObjectRef memo;
+			if (memo && res->data.clone(memo->data)) {
+				method.memo = move(memo);
 			}
 		}
-		return status;
 	}
 	else {
-		return Status::InvalidArgs;
+		if (res) {
+			res->data = Uninitialized {};
+		}
+	}
+	return status;
+}
+
+void Interpreter::set_budget(const EvalBudget& budget) {
+	budgeted = budget.statements || budget.time_ms;
+	budget_statements = budget.statements ? budget.statements : UINT64_MAX;
+	budget_deadline = budget.time_ms ? qacpi_os_timer() * 100 + budget.time_ms * (1000 * 1000) : 0;
+	budget_ticks = 0;
+}
+
+// called before each statement, at least one statement is run after setting a budget
+bool Interpreter::out_of_budget() {
+	if (!budget_statements) {
+		return true;
+	}
+	--budget_statements;
+	if (budget_deadline && ++budget_ticks % LOOP_TIMER_INTERVAL == 0) {
+		return qacpi_os_timer() * 100 >= budget_deadline;
+	}
+	return false;
+}
+
+static uint64_t wait_deadline(uint64_t ms) {
+	auto now = qacpi_os_timer();
+	if (ms > (UINT64_MAX - now) / (1000 * 10)) {
+		return UINT64_MAX;
+	}
+	return now + ms * (1000 * 10);
+}
+
+// the first call starts the wait, the op is then retried until this returns false
+bool Interpreter::still_waiting(decltype(WaitCondition::type) type, void* handle, uint64_t timeout_ms) {
+	if (wait.type != type) {
+		wait = {.type = type, .handle = handle, .deadline = wait_deadline(timeout_ms)};
+	}
+	if (qacpi_os_timer() < wait.deadline) {
+		return true;
+	}
+	wait.type = WaitCondition::None;
+	return false;
+}
+
+// the aml of a table loaded from a buffer is freed if the load fails, package literals from
+// it can't point into it as they might have been copied somewhere else by then
+void* Interpreter::mutex_key() {
+	return suspendable ? static_cast<void*>(this) : qacpi_os_get_tid();
+}
+
+// serialized methods may call themselves, the mutex is then only released by the outermost call.
+// like Acquire an async evaluation is suspended while another one holds the mutex.
+Status Interpreter::lock_serialized(Mutex& mutex) {
+	auto key = mutex_key();
+	if (mutex.is_owned_by(key)) {
+		++mutex.recursion;
+		return Status::Success;
+	}
+	if (!async) {
+		return mutex.lock(0xFFFF, key);
+	}
+
+	auto status = mutex.lock(0, key);
+	if (status == Status::TimeOut && still_waiting(WaitCondition::Acquire, mutex.handle, UINT64_MAX)) {
+		return Status::Suspended;
+	}
+	wait.type = WaitCondition::None;
+	return status;
+}
+
+void Interpreter::unlock_serialized(Mutex& mutex) {
+	if (mutex.recursion) {
+		--mutex.recursion;
+	}
+	else {
+		mutex.unlock();
+	}
+}
+
+bool Interpreter::can_defer_package() {
+	for (size_t i = frames.size(); i > 0; --i) {
+		if (frames[i - 1].data_buf) {
+			return false;
+		}
+	}
+	return true;
+}
+
+Status Interpreter::resume(ObjectRef& res, const EvalBudget& budget) {
+	// the time spent suspended doesn't count towards the loop timeout unless the code was waiting
+	if (wait.type == WaitCondition::None) {
+		auto suspended_for = qacpi_os_timer() * 100 - suspend_time;
+		for (size_t i = 0; i < frames.size(); ++i) {
+			if (frames[i].type == Frame::While) {
+				frames[i].expiration_time += suspended_for;
+			}
+		}
+	}
+
+	set_budget(budget);
+	if (serialize_pending) {
+		auto& method = eval_node->object->get_unsafe<Method>();
+		if (auto status = lock_serialized(*method.mutex); status != Status::Success) {
+			return finish_method(res, status);
+		}
+		serialize_pending = false;
+		method_frames[0].serialize_mutex = method.mutex;
 	}
+	return finish_method(res, parse());
 }
 
 static constexpr const char* CHARS = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXZ";
@@ -250,32 +395,49 @@ static uint64_t str_to_int(StringView str, unsigned int base) {
 
 Status Interpreter::handle_name(Interpreter::Frame& frame, bool need_result, bool super_name) {
 	--frame.ptr;
-	String str;
-	if (auto status = parse_name_str(frame, str); status != Status::Success) {
-		return status;
+
+	auto* entry = get_cache_entry(frame);
+	auto* node = get_cached_node(frame, entry);
+	if (node) {
+		frame.ptr += entry->width;
 	}
+	else {
+		auto* start = frame.ptr;
+		NamePath path;
+		if (auto status = parse_name_path(frame, path); status != Status::Success) {
+			return status;
+		}
 
-	auto* node = create_or_get_node(str, Context::SearchFlags::Search);
-	if (!node) {
-		if (frame.type == Frame::Package) {
-			ObjectRef obj;
-			if (!obj) {
-				return Status::NoMemory;
+		node = create_or_get_node(path, Context::SearchFlags::Search);
+		if (!node) {
+			if (frame.type == Frame::Package) {
+				String str;
+				if (!name_path_to_str(path, str)) {
+					return Status::NoMemory;
+				}
+
+				ObjectRef obj;
+				if (!obj) {
+					return Status::NoMemory;
+				}
+				str.mark_as_path();
+				obj->data = move(str);
+				if (!objects.push(move(obj))) {
+					return Status::NoMemory;
+				}
+				return Status::Success;
 			}
-			str.mark_as_path();
-			obj->data = move(str);
-			if (!objects.push(move(obj))) {
-				return Status::NoMemory;
+
+			if (context->log_level >= LogLevel::Warning) {
+				LOG << "qacpi warning: node " << path << " was not found" << endlog;
 			}
-			return Status::Success;
+			return Status::NotFound;
 		}
 
-		if (context->log_level >= LogLevel::Warning) {
-			LOG << "qacpi warning: node " << str << " was not found" << endlog;
-		}
-		return Status::NotFound;
+		cache_node(entry, frame.ptr - start, node);
 	}
-	else if (!node->object) {
+
+	if (!node->object) {
 		LOG << "qacpi: internal error in handle_name, node->object is null" << endlog;
 		return Status::InternalError;
 	}
@@ -292,15 +454,6 @@ Status Interpreter::handle_name(Interpreter::Frame& frame, bool need_result, boo
 			return Status::Success;
 		}
 
-		if (method->serialized) {
-			if (method->mutex->is_owned_by_thread()) {
-				++method->mutex->recursion;
-			}
-			else {
-				method->mutex->lock(0xFFFF);
-			}
-		}
-
 		OpBlockCtx block {
 			.block = &CALL_BLOCK,
 			.objects_at_start = static_cast<uint32_t>(objects.size()),
@@ -377,9 +530,21 @@ static ObjectRef& unwrap_internal_refs(ObjectRef& obj) {
 	return *ptr;
 }
 
-static ObjectRef& unwrap_refs(ObjectRef& obj) {
+// a reference into a package has to follow its element once something unshared or boxed the package
+void Interpreter::sync_element_ref(Ref& ref) {
+	if (!ref.owner) {
+		return;
+	}
+	auto package = ref.owner->get<Package>();
+	if (package && ref.index < package->size() && package->data->elements) {
+		ref.inner = package->data->elements[ref.index];
+	}
+}
+
+ObjectRef& Interpreter::unwrap_refs(ObjectRef& obj) {
 	auto ptr = &obj;
 	while (auto ref = (*ptr)->data.get<Ref>()) {
+		sync_element_ref(*ref);
 		ptr = &ref->inner;
 	}
 
@@ -405,7 +570,7 @@ Status Interpreter::try_convert(ObjectRef& object, ObjectRef& res, const ObjectT
 	}
 
 	if (!res) {
-		res = ObjectRef {};
+		res = new_temp();
 		if (!res) {
 			return Status::NoMemory;
 		}
@@ -592,6 +757,9 @@ Status Interpreter::try_convert(ObjectRef& object, ObjectRef& res, const ObjectT
 		uint64_t value = *integer;
 		if (find_type(ObjectType::Buffer)) {
 			if ((buf = res->get<Buffer>())) {
+				if (!buf->unshare()) {
+					return Status::NoMemory;
+				}
 				uint32_t copy = QACPI_MIN(buf->size(), int_size);
 				memcpy(buf->data(), integer, copy);
 				memset(buf->data() + copy, 0, buf->size() - copy);
@@ -696,6 +864,22 @@ static void debug_output(ObjectRef value) {
 	});
 }
 
+// a package referenced by Index is only unshared and boxed once something is stored through the reference
+bool Interpreter::box_element_ref(Ref& ref) {
+	if (!ref.owner) {
+		return true;
+	}
+	auto package = ref.owner->get<Package>();
+	if (!package || ref.index >= package->size()) {
+		return true;
+	}
+	if (!package->unshare() || !package->box()) {
+		return false;
+	}
+	ref.inner = package->data->elements[ref.index];
+	return true;
+}
+
 Status Interpreter::store_to_target(ObjectRef target, ObjectRef value) {
 	if (target->get<NullTarget>()) {
 		return Status::Success;
@@ -715,9 +899,18 @@ Status Interpreter::store_to_target(ObjectRef target, ObjectRef value) {
 		real_target = unwrap_internal_refs(ref->inner);
 		if (auto inner_ref = real_target->get<Ref>()) {
 			copy_obj = ref->type == Ref::Arg;
+			if (!box_element_ref(*inner_ref)) {
+				return Status::NoMemory;
+			}
 			real_target = unwrap_refs(inner_ref->inner);
 		}
 		else {
+			if (ref->owner) {
+				if (!box_element_ref(*ref)) {
+					return Status::NoMemory;
+				}
+				real_target = ref->inner;
+			}
 			if (ref->type == Ref::Arg) {
 				real_target = target;
 			}
@@ -733,6 +926,17 @@ Status Interpreter::store_to_target(ObjectRef target, ObjectRef value) {
 	}
 
 	if (auto buf_field = real_target->get<BufferField>()) {
+		// Index also creates buffer fields for strings
+		bool unshared;
+		if (auto str = buf_field->owner->get<String>()) {
+			unshared = str->unshare();
+		}
+		else {
+			unshared = buf_field->owner->get_unsafe<Buffer>().unshare();
+		}
+		if (!unshared) {
+			return Status::NoMemory;
+		}
 		auto& owner = buf_field->owner->get_unsafe<Buffer>();
 
 		if (buf_field->byte_size <= int_size) {
@@ -813,6 +1017,9 @@ Status Interpreter::store_to_target(ObjectRef target, ObjectRef value) {
 	}
 	else {
 		if (auto str = real_target->get<String>()) {
+			if (!str->unshare()) {
+				return Status::NoMemory;
+			}
 			auto obj = ObjectRef::empty();
 			if (auto status = try_convert(real_value, obj, {ObjectType::String});
 				status != Status::Success) {
@@ -825,6 +1032,9 @@ Status Interpreter::store_to_target(ObjectRef target, ObjectRef value) {
 			return Status::Success;
 		}
 		else if (auto buf = real_target->get<Buffer>()) {
+			if (!buf->unshare()) {
+				return Status::NoMemory;
+			}
 			auto obj = ObjectRef::empty();
 			if (auto status = try_convert(real_value, obj, {ObjectType::Buffer});
 				status != Status::Success) {
@@ -858,24 +1068,24 @@ Status Interpreter::store_to_target(ObjectRef target, ObjectRef value) {
 	return Status::Success;
 }
 
-Status Interpreter::parse_name_str(Interpreter::Frame& frame, String& res) {
-	CHECK_EOF;
+Status Interpreter::parse_name_path(Interpreter::Frame& frame, NamePath& res) {
+	CHECK_OPERAND_EOF;
 
-	uint32_t prefix_size = 0;
+	res.absolute = false;
+	res.parent_count = 0;
 
-	auto prefix = reinterpret_cast<const char*>(frame.ptr);
 	auto c = static_cast<char>(*frame.ptr);
 	if (c == RootChar) {
-		prefix_size = 1;
+		res.absolute = true;
 		++frame.ptr;
-		CHECK_EOF;
+		CHECK_OPERAND_EOF;
 		c = static_cast<char>(*frame.ptr);
 	}
 	else if (c == ParentPrefixChar) {
 		while (c == ParentPrefixChar) {
 			++frame.ptr;
-			++prefix_size;
-			CHECK_EOF;
+			++res.parent_count;
+			CHECK_OPERAND_EOF;
 			c = static_cast<char>(*frame.ptr);
 		}
 	}
@@ -883,11 +1093,8 @@ Status Interpreter::parse_name_str(Interpreter::Frame& frame, String& res) {
 	uint32_t num_segs = 1;
 	if (c == 0) {
 		++frame.ptr;
-
-		if (!res.init(prefix, prefix_size)) {
-			return Status::NoMemory;
-		}
-
+		res.segments = frame.ptr;
+		res.segment_count = 0;
 		return Status::Success;
 	}
 	else if (c == DualNamePrefix) {
@@ -896,32 +1103,20 @@ Status Interpreter::parse_name_str(Interpreter::Frame& frame, String& res) {
 	}
 	else if (c == MultiNamePrefix) {
 		++frame.ptr;
-		CHECK_EOF;
+		CHECK_OPERAND_EOF;
 		num_segs = *frame.ptr++;
 	}
 
-	CHECK_EOF_NUM(num_segs * 4);
-	if (!res.init_with_size(prefix_size + num_segs * 4 + (num_segs - 1))) {
-		return Status::NoMemory;
-	}
-
-	auto data = res.data();
-	memcpy(data, prefix, prefix_size);
-	data += prefix_size;
-	for (uint32_t i = 0; i < num_segs; ++i) {
-		for (uint32_t j = 0; j < 4; ++j) {
-			*data++ = static_cast<char>(*frame.ptr++);
-		}
-		if (i != num_segs - 1) {
-			*data++ = '.';
-		}
-	}
+	CHECK_OPERAND_EOF_NUM(num_segs * 4);
+	res.segments = frame.ptr;
+	res.segment_count = num_segs;
+	frame.ptr += num_segs * 4;
 
 	return Status::Success;
 }
 
 Status Interpreter::parse_pkg_len(Interpreter::Frame& frame, PkgLength& res) {
-	CHECK_EOF;
+	CHECK_OPERAND_EOF;
 	auto* start = frame.ptr;
 	auto first = *frame.ptr++;
 	uint8_t count = first >> 6;
@@ -931,7 +1126,7 @@ Status Interpreter::parse_pkg_len(Interpreter::Frame& frame, PkgLength& res) {
 		value = first & 0b111111;
 	}
 	else {
-		CHECK_EOF_NUM(count);
+		CHECK_OPERAND_EOF_NUM(count);
 		value = first & 0xF;
 		for (int i = 0; i < count; ++i) {
 			value |= *frame.ptr++ << (4 + i * 8);
@@ -944,103 +1139,518 @@ Status Interpreter::parse_pkg_len(Interpreter::Frame& frame, PkgLength& res) {
 	return Status::Success;
 }
 
-Status Interpreter::parse_field(FieldList& list, Frame& frame) {
-	uint8_t access_type = list.flags & 0xF;
-	bool lock = list.flags >> 4 & 1;
-	auto update = static_cast<FieldUpdate>(list.flags >> 5 & 0b11);
+MethodCache::~MethodCache() {
+	if (entries) {
+		deallocate(entries, size * sizeof(Entry));
+	}
+}
 
-	CHECK_EOF;
-	auto byte = *frame.ptr;
-	// ReservedField := 0x0 PkgLength
-	if (byte == 0x0) {
-		++frame.ptr;
-		PkgLength pkg_len {};
-		if (auto status = parse_pkg_len(frame, pkg_len); status != Status::Success) {
-			return status;
-		}
-		list.offset += pkg_len.len;
+MethodNames::~MethodNames() {
+	if (entries) {
+		deallocate(entries, count * sizeof(Entry));
 	}
-	// AccessField := 0x1 AccessType AccessAttrib
-	// ExtendedAccessField := 0x3 AccessType AccessAttrib AccessLength
-	else if (byte == 0x1 || byte == 0x3) {
-		++frame.ptr;
-		CHECK_EOF;
-		auto access_type_byte = *frame.ptr++;
-		access_type = access_type_byte & 0xF;
+}
 
-		CHECK_EOF;
-		// access_attrib
-		++frame.ptr;
+MethodNames::Entry* MethodNames::get(uint32_t index) {
+	if (index >= count) {
+		uint32_t new_count = count ? count * 2 : 8;
+		while (new_count <= index) {
+			new_count *= 2;
+		}
+		auto* new_entries = static_cast<Entry*>(allocate(new_count * sizeof(Entry)));
+		if (!new_entries) {
+			return nullptr;
+		}
+		memset(new_entries, 0, new_count * sizeof(Entry));
+		if (entries) {
+			memcpy(new_entries, entries, count * sizeof(Entry));
+			deallocate(entries, count * sizeof(Entry));
+		}
+		entries = new_entries;
+		count = new_count;
+	}
 
-		// access_length
-		if (byte == 0x3) {
-			CHECK_EOF;
+	return &entries[index];
+}
 
-			++frame.ptr;
-		}
+bool MethodCache::init(uint32_t new_size) {
+	if (!new_size) {
+		return true;
 	}
-	// ConnectField := <0x2 NameString> | <0x2 BufferData>
-	else if (byte == 0x2) {
-		++frame.ptr;
-		CHECK_EOF;
 
-		if (is_name_char(*frame.ptr)) {
-			String str;
-			if (auto status = parse_name_str(frame, str); status != Status::Success) {
-				return status;
-			}
+	entries = static_cast<Entry*>(allocate(new_size * sizeof(Entry)));
+	if (!entries) {
+		return false;
+	}
+	memset(entries, 0, new_size * sizeof(Entry));
+	size = new_size;
+	return true;
+}
 
-			ObjectRef obj;
-			if (!obj) {
-				return Status::NoMemory;
-			}
-			str.mark_as_path();
-			obj->data = move(str);
-			if (auto status = resolve_object(obj); status != Status::Success) {
-				return status;
-			}
+void Interpreter::use_method_cache(MethodFrame& method_frame, Method& method) {
+	if (!method.cache) {
+		method.cache = SharedPtr<MethodCache> {};
+		if (!method.cache) {
+			return;
+		}
+	}
 
-			if (!objects.push(move(obj))) {
-				return Status::NoMemory;
-			}
-			frames.back().ptr = list.frame.ptr;
-			list.connect_field_part2 = true;
+	// only methods that get invoked more than once are worth the memory
+	auto& cache = *method.cache;
+	if (!cache.entries) {
+		if (!cache.invoked) {
+			cache.invoked = true;
+			return;
 		}
-		else {
-			list.connect_field = true;
+		if (!cache.init(method.size)) {
+			return;
 		}
 	}
-	else {
-		CHECK_EOF_NUM(4);
-		auto* name = reinterpret_cast<const char*>(frame.ptr);
-		frame.ptr += 4;
 
-		PkgLength pkg_len {};
-		if (auto status = parse_pkg_len(frame, pkg_len); status != Status::Success) {
-			return status;
+	if (!method.names) {
+		method.names = SharedPtr<MethodNames> {};
+		if (!method.names) {
+			return;
 		}
+	}
 
-		uint8_t access_size = 0;
-		switch (access_type) {
-			// AnyAcc
-			case 0:
-			// ByteAcc
-			case 1:
-			// BufferAcc
-			case 5:
-				access_size = 1;
-				break;
-			// WordAcc
-			case 2:
-				access_size = 2;
-				break;
-			// DWordAcc
-			case 3:
-				access_size = 4;
-				break;
-			// QWordAcc
-			case 4:
-				access_size = 8;
+	method_frame.cache = method.cache;
+	method_frame.names = method.names;
+	method_frame.aml = method.aml;
+}
+
+MethodCache::Entry* Interpreter::get_cache_entry(const Frame& frame) {
+	if (method_frames.is_empty()) {
+		return nullptr;
+	}
+
+	auto& method_frame = method_frames.back();
+	if (!method_frame.cache) {
+		return nullptr;
+	}
+
+	auto offset = reinterpret_cast<uintptr_t>(frame.ptr) - reinterpret_cast<uintptr_t>(method_frame.aml);
+	if (offset >= method_frame.cache->size) {
+		return nullptr;
+	}
+	return &method_frame.cache->entries[offset];
+}
+
+NamespaceNode* Interpreter::get_cached_node(const Frame& frame, const MethodCache::Entry* entry) {
+	if (!entry || entry->kind != MethodCache::Entry::Name || !entry->value ||
+		(!frame.verified && frame.ptr + entry->width > frame.end)) {
+		return nullptr;
+	}
+
+	auto& names = *method_frames.back().names;
+	if (entry->value > names.count) {
+		return nullptr;
+	}
+	auto& name = names.entries[entry->value - 1];
+	if (name.generation != context->ns_generation || name.scope != current_scope) {
+		return nullptr;
+	}
+	return name.node;
+}
+
+void Interpreter::cache_node(MethodCache::Entry* entry, uint32_t name_size, NamespaceNode* node) {
+	if (!entry || entry->kind != MethodCache::Entry::Name || name_size > 0xFF) {
+		return;
+	}
+
+	auto& method_frame = method_frames.back();
+	if (!entry->value) {
+		entry->value = ++method_frame.cache->name_count;
+		entry->width = name_size;
+	}
+
+	auto* name = method_frame.names->get(entry->value - 1);
+	if (!name) {
+		return;
+	}
+
+	name->scope = current_scope;
+	name->node = node;
+	name->generation = context->ns_generation;
+}
+
+static constexpr uint32_t MAX_FOLD_DEPTH = 16;
+
+static bool fold_integer_expr(const uint8_t*& ptr, const uint8_t* end, uint64_t& res, uint32_t depth) {
+	if (ptr == end || depth == MAX_FOLD_DEPTH) {
+		return false;
+	}
+
+	auto op = *ptr++;
+	switch (op) {
+		case ZeroOp:
+			res = 0;
+			return true;
+		case OneOp:
+			res = 1;
+			return true;
+		case OnesOp:
+			res = 0xFFFFFFFFFFFFFFFF;
+			return true;
+		case BytePrefix:
+			if (ptr == end) {
+				return false;
+			}
+			res = *ptr++;
+			return true;
+		case WordPrefix:
+		case DWordPrefix:
+		case QWordPrefix:
+		{
+			uint32_t size = op == WordPrefix ? 2 : op == DWordPrefix ? 4 : 8;
+			if (ptr + size > end) {
+				return false;
+			}
+			res = 0;
+			memcpy(&res, ptr, size);
+			ptr += size;
+			return true;
+		}
+		case NotOp:
+		case LNotOp:
+		{
+			uint64_t value;
+			if (!fold_integer_expr(ptr, end, value, depth + 1)) {
+				return false;
+			}
+			if (op == NotOp) {
+				// only a NullTarget keeps the expression free of side effects
+				if (ptr == end || *ptr++ != ZeroOp) {
+					return false;
+				}
+				res = ~value;
+			}
+			else {
+				res = !value;
+			}
+			return true;
+		}
+		case AddOp:
+		case SubtractOp:
+		case MultiplyOp:
+		case DivideOp:
+		case ShiftLeftOp:
+		case ShiftRightOp:
+		case AndOp:
+		case NandOp:
+		case OrOp:
+		case NorOp:
+		case XorOp:
+		case ModOp:
+		case LAndOp:
+		case LOrOp:
+		case LEqualOp:
+		case LGreaterOp:
+		case LLessOp:
+		{
+			uint64_t lhs;
+			uint64_t rhs;
+			if (!fold_integer_expr(ptr, end, lhs, depth + 1) ||
+				!fold_integer_expr(ptr, end, rhs, depth + 1)) {
+				return false;
+			}
+
+			uint32_t targets = op == DivideOp ? 2 : op >= LAndOp ? 0 : 1;
+			for (uint32_t i = 0; i < targets; ++i) {
+				if (ptr == end || *ptr++ != ZeroOp) {
+					return false;
+				}
+			}
+
+			switch (op) {
+				case AddOp:
+					res = lhs + rhs;
+					break;
+				case SubtractOp:
+					res = lhs - rhs;
+					break;
+				case MultiplyOp:
+					res = lhs * rhs;
+					break;
+				case DivideOp:
+				case ModOp:
+					// leave the error reporting to the interpreter
+					if (!rhs) {
+						return false;
+					}
+					res = op == DivideOp ? lhs / rhs : lhs % rhs;
+					break;
+				case ShiftLeftOp:
+					res = rhs < 64 ? lhs << rhs : 0;
+					break;
+				case ShiftRightOp:
+					res = rhs < 64 ? lhs >> rhs : 0;
+					break;
+				case AndOp:
+					res = lhs & rhs;
+					break;
+				case NandOp:
+					res = ~(lhs & rhs);
+					break;
+				case OrOp:
+					res = lhs | rhs;
+					break;
+				case NorOp:
+					res = ~(lhs | rhs);
+					break;
+				case XorOp:
+					res = lhs ^ rhs;
+					break;
+				case LAndOp:
+					res = lhs && rhs;
+					break;
+				case LOrOp:
+					res = lhs || rhs;
+					break;
+				case LEqualOp:
+					res = lhs == rhs;
+					break;
+				case LGreaterOp:
+					res = lhs > rhs;
+					break;
+				case LLessOp:
+					res = lhs < rhs;
+					break;
+				default:
+					return false;
+			}
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+bool Interpreter::fold_integer(Frame& frame, uint64_t& res) {
+	auto* ptr = frame.ptr;
+	if (!fold_integer_expr(ptr, frame.end, res, 0)) {
+		return false;
+	}
+	frame.ptr = ptr;
+	return true;
+}
+
+Status Interpreter::push_integer(uint64_t value) {
+	auto obj = ObjectRef::empty();
+	if (value < Context::CONSTANT_ONES) {
+		obj = context->get_constant(static_cast<uint32_t>(value));
+	}
+	else if (value == 0xFFFFFFFFFFFFFFFF) {
+		obj = context->get_constant(Context::CONSTANT_ONES);
+	}
+	else {
+		obj = new_temp();
+		if (obj) {
+			obj->data = value;
+		}
+	}
+
+	if (!obj || !objects.push(move(obj))) {
+		return Status::NoMemory;
+	}
+	return Status::Success;
+}
+
+ObjectRef Interpreter::new_temp() {
+	for (uint32_t i = 0; i < TEMP_PROBES && i < temps.size(); ++i) {
+		auto& temp = temps[temp_cursor];
+		temp_cursor = (temp_cursor + 1) % temps.size();
+		if (temp.is_unique()) {
+			temp->data = decltype(temp->data) {};
+			temp->node = nullptr;
+			return temp;
+		}
+	}
+
+	ObjectRef obj;
+	if (obj && temps.size() < TEMP_COUNT) {
+		(void) temps.push(obj);
+	}
+	return obj;
+}
+
+Status Interpreter::decode_op(Frame& frame, const OpBlock*& block) {
+	auto* entry = get_cache_entry(frame);
+	if (entry && frame.ptr + entry->width <= frame.end) {
+		if (entry->kind == MethodCache::Entry::Op) {
+			frame.ptr += entry->width;
+			block = entry->value & 0x100 ? &EXT_OPS[entry->value & 0xFF] : &OPS[entry->value];
+			return Status::Success;
+		}
+		else if (entry->kind == MethodCache::Entry::Name) {
+			++frame.ptr;
+			block = nullptr;
+			return Status::Success;
+		}
+	}
+
+	CHECK_EOF;
+	auto byte = *frame.ptr++;
+
+	uint32_t value = byte;
+	uint8_t width = 1;
+	switch (BYTE_CLASSES[byte]) {
+		case ByteClass::Op:
+		case ByteClass::Invalid:
+			block = &OPS[byte];
+			break;
+		case ByteClass::ExtOpPrefix:
+			CHECK_OPERAND_EOF;
+			value = 0x100 | *frame.ptr++;
+			width = 2;
+			block = &EXT_OPS[value & 0xFF];
+			break;
+		case ByteClass::NameChar:
+			if (entry) {
+				*entry = {
+					.value = 0,
+					.kind = MethodCache::Entry::Name,
+					.width = 1
+				};
+			}
+			block = nullptr;
+			return Status::Success;
+	}
+
+	if (entry && block->handler != OpHandler::None) {
+		*entry = {
+			.value = value,
+			.kind = MethodCache::Entry::Op,
+			.width = width
+		};
+	}
+
+	return Status::Success;
+}
+
+Status Interpreter::decode_pkg_len(Frame& frame, PkgLength& res) {
+	auto* entry = get_cache_entry(frame);
+	if (entry && entry->kind == MethodCache::Entry::PkgLength &&
+		(frame.verified || frame.ptr + entry->width <= frame.end)) {
+		res.start = frame.ptr;
+		res.len = entry->value;
+		frame.ptr += entry->width;
+		return Status::Success;
+	}
+
+	auto* start = frame.ptr;
+	if (auto status = parse_pkg_len(frame, res); status != Status::Success) {
+		return status;
+	}
+
+	if (entry) {
+		*entry = {
+			.value = res.len,
+			.kind = MethodCache::Entry::PkgLength,
+			.width = static_cast<uint8_t>(frame.ptr - start)
+		};
+	}
+
+	return Status::Success;
+}
+
+Status Interpreter::parse_field(FieldList& list, Frame& frame) {
+	uint8_t access_type = list.flags & 0xF;
+	bool lock = list.flags >> 4 & 1;
+	auto update = static_cast<FieldUpdate>(list.flags >> 5 & 0b11);
+
+	CHECK_EOF;
+	auto byte = *frame.ptr;
+	// ReservedField := 0x0 PkgLength
+	if (byte == 0x0) {
+		++frame.ptr;
+		PkgLength pkg_len {};
+		if (auto status = parse_pkg_len(frame, pkg_len); status != Status::Success) {
+			return status;
+		}
+		list.offset += pkg_len.len;
+	}
+	// AccessField := 0x1 AccessType AccessAttrib
+	// ExtendedAccessField := 0x3 AccessType AccessAttrib AccessLength
+	else if (byte == 0x1 || byte == 0x3) {
+		++frame.ptr;
+		CHECK_EOF;
+		auto access_type_byte = *frame.ptr++;
+		access_type = access_type_byte & 0xF;
+
+		CHECK_EOF;
+		// access_attrib
+		++frame.ptr;
+
+		// access_length
+		if (byte == 0x3) {
+			CHECK_EOF;
+
+			++frame.ptr;
+		}
+	}
+	// ConnectField := <0x2 NameString> | <0x2 BufferData>
+	else if (byte == 0x2) {
+		++frame.ptr;
+		CHECK_EOF;
+
+		if (is_name_char(*frame.ptr)) {
+			NamePath path;
+			if (auto status = parse_name_path(frame, path); status != Status::Success) {
+				return status;
+			}
+
+			auto* node = create_or_get_node(path, Context::SearchFlags::Search);
+			if (!node) {
+				return Status::NotFound;
+			}
+			else if (!node->object) {
+				LOG << "qacpi: internal error in parse_field, node->object is null" << endlog;
+				return Status::InternalError;
+			}
+
+			auto obj = node->object;
+			if (!objects.push(move(obj))) {
+				return Status::NoMemory;
+			}
+			frames.back().ptr = list.frame.ptr;
+			list.connect_field_part2 = true;
+		}
+		else {
+			list.connect_field = true;
+		}
+	}
+	else {
+		CHECK_EOF_NUM(4);
+		auto* name = reinterpret_cast<const char*>(frame.ptr);
+		frame.ptr += 4;
+
+		PkgLength pkg_len {};
+		if (auto status = parse_pkg_len(frame, pkg_len); status != Status::Success) {
+			return status;
+		}
+
+		uint8_t access_size = 0;
+		switch (access_type) {
+			// AnyAcc
+			case 0:
+			// ByteAcc
+			case 1:
+			// BufferAcc
+			case 5:
+				access_size = 1;
+				break;
+			// WordAcc
+			case 2:
+				access_size = 2;
+				break;
+			// DWordAcc
+			case 3:
+				access_size = 4;
+				break;
+			// QWordAcc
+			case 4:
+				access_size = 8;
 				break;
 			default:
 				LOG << "qacpi error: Reserved field access size" << endlog;
@@ -1132,14 +1742,15 @@ Status Interpreter::unwind_stack() {
 		}
 		else {
 			auto& method_frame = method_frames.back();
-			if (method_frame.table_target) {
+			auto* load_table = method_frame.load_table;
+			if (load_table && load_table->table_target) {
 				ObjectRef obj;
 				if (!obj) {
 					return Status::NoMemory;
 				}
 				obj->data = uint64_t {0};
 
-				if (auto status = store_to_target(method_frame.table_target, obj);
+				if (auto status = store_to_target(load_table->table_target, obj);
 					status != Status::Success) {
 					return status;
 				}
@@ -1153,17 +1764,18 @@ Status Interpreter::unwind_stack() {
 				current_scope = frame_iter.parent_scope;
 
 				// delete nodes in case of a load failure
-				method_frame.table_target = ObjectRef::empty();
+				load_table->table_target = ObjectRef::empty();
 
 				if (frame_iter.data_buf) {
-					qacpi_os_free(frame_iter.data_buf, frame_iter.data_buf_size);
+					context->forget_method_bodies(frame_iter.data_buf, frame_iter.data_buf_size);
+					deallocate(frame_iter.data_buf, frame_iter.data_buf_size);
 				}
 
 				frames.pop_discard();
 				method_frames.pop_discard();
 				break;
 			}
-			else if (method_frame.load_table_param) {
+			else if (load_table && load_table->param) {
 				if (frame_iter.need_load_result) {
 					ObjectRef obj;
 					if (!obj) {
@@ -1179,7 +1791,7 @@ Status Interpreter::unwind_stack() {
 				current_scope = frame_iter.parent_scope;
 
 				// delete nodes in case of a load failure
-				method_frame.load_table_param = ObjectRef::empty();
+				load_table->param = ObjectRef::empty();
 
 				frames.pop_discard();
 				method_frames.pop_discard();
@@ -1236,7 +1848,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		{
 			auto* start = reinterpret_cast<const char*>(frame.ptr);
 			while (true) {
-				CHECK_EOF;
+				CHECK_OPERAND_EOF;
 				auto c = *frame.ptr++;
 				if (c == 0) {
 					break;
@@ -1478,54 +2090,59 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::Constant:
 		{
 			auto op = *(frame.ptr - 1);
-			Object value;
+			uint64_t value = 0;
+			uint32_t constant;
 
 			if (op == ZeroOp) {
-				if (block.as_ref) {
-					value.data = NullTarget {};
-				}
-				else {
-					value.data = uint64_t {0};
-				}
+				constant = block.as_ref ? Context::CONSTANT_NULL_TARGET : 0;
 			}
 			else if (op == OneOp) {
-				value.data = uint64_t {1};
+				constant = 1;
 			}
 			else if (op == BytePrefix) {
-				CHECK_EOF;
-				value.data = uint64_t {*frame.ptr++};
-			}
-			else if (op == WordPrefix) {
-				CHECK_EOF_NUM(2);
-				uint16_t val;
-				memcpy(&val, frame.ptr, 2);
-				frame.ptr += 2;
-				value.data = uint64_t {val};
-			}
-			else if (op == DWordPrefix) {
-				CHECK_EOF_NUM(4);
-				uint32_t val;
-				memcpy(&val, frame.ptr, 4);
-				frame.ptr += 4;
-				value.data = uint64_t {val};
-			}
-			else if (op == QWordPrefix) {
-				CHECK_EOF_NUM(8);
-				uint64_t val;
-				memcpy(&val, frame.ptr, 8);
-				frame.ptr += 8;
-				value.data = val;
+				CHECK_OPERAND_EOF;
+				constant = *frame.ptr++;
 			}
 			else if (op == OnesOp) {
-				value.data = uint64_t {0xFFFFFFFFFFFFFFFF};
+				constant = Context::CONSTANT_ONES;
+			}
+			else {
+				if (op == WordPrefix) {
+					CHECK_OPERAND_EOF_NUM(2);
+					uint16_t val;
+					memcpy(&val, frame.ptr, 2);
+					frame.ptr += 2;
+					value = val;
+				}
+				else if (op == DWordPrefix) {
+					CHECK_OPERAND_EOF_NUM(4);
+					uint32_t val;
+					memcpy(&val, frame.ptr, 4);
+					frame.ptr += 4;
+					value = val;
+				}
+				else if (op == QWordPrefix) {
+					CHECK_OPERAND_EOF_NUM(8);
+					memcpy(&value, frame.ptr, 8);
+					frame.ptr += 8;
+				}
+				constant = value < Context::CONSTANT_ONES ? static_cast<uint32_t>(value) : Context::CONSTANT_COUNT;
 			}
 
 			if (need_result) {
-				ObjectRef obj;
+				auto obj = ObjectRef::empty();
+				if (constant != Context::CONSTANT_COUNT) {
+					obj = context->get_constant(constant);
+				}
+				else {
+					obj = new_temp();
+					if (obj) {
+						obj->data = value;
+					}
+				}
 				if (!obj) {
 					return Status::NoMemory;
 				}
-				*obj = move(value);
 				if (!objects.push(move(obj))) {
 					return Status::NoMemory;
 				}
@@ -1536,7 +2153,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::Name:
 		{
 			auto value = pop_and_unwrap_obj();
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 
 			auto* node = create_or_get_node(name, Context::SearchFlags::Create);
 			if (!node) {
@@ -1562,7 +2179,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::Method:
 		{
 			auto flags = objects.pop().get_unsafe<PkgLength>().len;
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 			auto pkg_len = objects.pop().get_unsafe<PkgLength>();
 			uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
 
@@ -1601,12 +2218,17 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				}
 			}
 
+			bool verified = frame.verified;
+			auto cache = context->share_method_body(frame.ptr, len, verified);
+
 			obj->data = Method {
 				.aml = frame.ptr,
 				.mutex {move(mutex)},
 				.size = len,
 				.arg_count = static_cast<uint8_t>(flags & 0b111),
-				.serialized = serialized
+				.serialized = serialized,
+				.verified = verified,
+				.cache {move(cache)}
 			};
 			obj->node = node;
 			node->object = move(obj);
@@ -1618,6 +2240,26 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		{
 			auto& args = objects[block.objects_at_start].get_unsafe<MethodArgs>();
 
+			if (args.method->memo) {
+				auto copy = ObjectRef::empty();
+				if (need_result) {
+					copy = ObjectRef {};
+					if (!copy || !args.method->memo->data.clone(copy->data)) {
+						return Status::NoMemory;
+					}
+				}
+
+				for (int i = 0; i < args.method->arg_count; ++i) {
+					objects.pop_discard();
+				}
+				objects.pop_discard();
+
+				if (need_result && !objects.push(move(copy))) {
+					return Status::NoMemory;
+				}
+				break;
+			}
+
 			if (method_frames.size() == context->max_callstack_depth) {
 				for (int i = 0; i < args.method->arg_count; ++i) {
 					objects.pop_discard();
@@ -1632,8 +2274,19 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				break;
 			}
 
-			auto* new_frame = frames.push();
-			if (!new_frame) {
+			// taken here rather than when the name is decoded so that memoized calls and calls
+			// that fail before this point don't leave the mutex held
+			if (args.method->serialized) {
+				if (auto status = lock_serialized(*args.method->mutex); status != Status::Success) {
+					return status;
+				}
+			}
+
+			auto* new_frame = frames.push();
+			if (!new_frame) {
+				if (args.method->serialized) {
+					unlock_serialized(*args.method->mutex);
+				}
 				return Status::NoMemory;
 			}
 			new_frame->start = args.method->aml;
@@ -1642,19 +2295,24 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			new_frame->parent_scope = current_scope;
 			new_frame->need_result = need_result;
 			new_frame->is_method = true;
+			new_frame->verified = args.method->verified;
 			new_frame->type = Frame::Scope;
 
 			current_scope = args.method_node;
 
 			auto* method_frame = method_frames.push();
 			if (!method_frame) {
+				if (args.method->serialized) {
+					unlock_serialized(*args.method->mutex);
+				}
 				return Status::NoMemory;
 			}
 
 			method_frame->node_link = nullptr;
 			method_frame->serialize_mutex = args.method->mutex;
+			use_method_cache(*method_frame, *args.method);
 			for (int i = args.method->arg_count; i > 0; --i) {
-				ObjectRef arg_wrapper;
+				auto arg_wrapper = new_temp();
 				if (!arg_wrapper) {
 					return Status::NoMemory;
 				}
@@ -1663,7 +2321,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 
 				auto arg = ObjectRef::empty();
 				if (!real_arg->get<String>() && !real_arg->get<Buffer>() && !real_arg->get<Package>()) {
-					arg = ObjectRef {};
+					arg = new_temp();
 					if (!arg || !real_arg->data.clone(arg->data)) {
 						return Status::NoMemory;
 					}
@@ -1674,7 +2332,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 
 				arg_wrapper->data = Ref {.type = Ref::Arg, .inner {move(arg)}};
 
-				method_frame->args[i - 1] = move(arg_wrapper);
+				method_frame->arg(i - 1) = move(arg_wrapper);
 			}
 
 			objects.pop();
@@ -1702,25 +2360,26 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 
 				if (block.block->handler == OpHandler::Arg) {
 					auto num = *(frame.ptr - 1) - Arg0Op;
-					value = &method.args[num];
+					value = &method.arg(num);
 				}
 				else {
 					auto num = *(frame.ptr - 1) - Local0Op;
-					value = &method.locals[num];
+					value = &method.local(num);
 					is_local = true;
 				}
 			}
 
 			if (!*value) {
-				*value = ObjectRef {};
+				*value = new_temp();
 				if (!*value) {
 					return Status::NoMemory;
 				}
 
-				auto real_value = ObjectRef {Uninitialized {}};
+				auto real_value = new_temp();
 				if (!real_value) {
 					return Status::NoMemory;
 				}
+				real_value->data = Uninitialized {};
 				(*value)->data = Ref {
 					.type = is_local ? Ref::Local : Ref::Arg,
 					.inner {move(real_value)}};
@@ -1801,7 +2460,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 						memcpy(&value, str.data() + buffer_field->byte_offset, QACPI_MIN(str.size(), 1));
 					}
 
-					ObjectRef obj;
+					auto obj = new_temp();
 					if (!obj) {
 						return Status::NoMemory;
 					}
@@ -1842,6 +2501,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 						auto& other_ref = unwrapped_target->get_unsafe<Ref>();
 						if (!other_ref.inner->get<Ref>()) {
 							other_ref.inner = new_value;
+							other_ref.owner = ObjectRef::empty();
 							break;
 						}
 						unwrapped_target = other_ref.inner;
@@ -1901,8 +2561,12 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				if (real_size) {
 					memcpy(buf.data(), frame.ptr, init_len);
 				}
-				obj->data = move(buf);
-				if (!objects.push(move(obj))) {
+				// obj may be the size operand itself (a shared constant or a named object)
+				ObjectRef res {move(buf)};
+				if (!res) {
+					return Status::NoMemory;
+				}
+				if (!objects.push(move(res))) {
 					return Status::NoMemory;
 				}
 			}
@@ -1914,15 +2578,68 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		{
 			auto num_elements = objects[block.objects_at_start - 1].get_unsafe<PkgLength>().len;
 			uint32_t num_init_elements = objects.size() - block.objects_at_start;
+
+			if (num_init_elements == 1 && objects.back().get<PkgLength>()) {
+				auto lazy = objects.pop().get_unsafe<PkgLength>();
+				auto pkg_len = objects[block.objects_at_start - 2].get_unsafe<PkgLength>();
+				objects.pop();
+				objects.pop();
+
+				if (need_result) {
+					Package package {};
+					if (!package.data) {
+						return Status::NoMemory;
+					}
+					package.init_lazy(
+						lazy.start,
+						pkg_len.start + pkg_len.len - lazy.start,
+						QACPI_MAX(num_elements, lazy.len));
+
+					ObjectRef obj {};
+					if (!obj) {
+						return Status::NoMemory;
+					}
+					obj->data = move(package);
+					if (!objects.push(move(obj))) {
+						return Status::NoMemory;
+					}
+				}
+				break;
+			}
+
 			uint32_t real_num_elements = QACPI_MAX(num_elements, num_init_elements);
 
-			Package package {};
-			if (!package.init(real_num_elements)) {
-				return Status::NoMemory;
+			// named integers are kept as elements so that the package aliases them like other named objects
+			bool packed = num_init_elements == num_elements;
+			for (uint32_t i = block.objects_at_start; packed && i < objects.size(); ++i) {
+				auto& element = unwrap_internal_refs(objects[i].get_unsafe<ObjectRef>());
+				packed = element->get<uint64_t>() && !element->node;
 			}
 
-			for (uint32_t i = num_init_elements; i > 0; --i) {
-				package.data->elements[i - 1] = pop_and_unwrap_obj();
+			Package package {};
+			if (packed) {
+				if (!package.init_integers(real_num_elements)) {
+					return Status::NoMemory;
+				}
+				for (uint32_t i = num_init_elements; i > 0; --i) {
+					package.data->integers[i - 1] = pop_and_unwrap_obj()->get_unsafe<uint64_t>();
+				}
+			}
+			else {
+				if (!package.init(real_num_elements)) {
+					return Status::NoMemory;
+				}
+				for (uint32_t i = num_init_elements; i > 0; --i) {
+					auto element = pop_and_unwrap_obj();
+					if (context->is_constant(element)) {
+						ObjectRef copy;
+						if (!copy || !element->data.clone(copy->data)) {
+							return Status::NoMemory;
+						}
+						element = move(copy);
+					}
+					package.data->elements[i - 1] = move(element);
+				}
 			}
 			for (uint32_t i = num_init_elements; i < num_elements; ++i) {
 				ObjectRef obj {};
@@ -2012,8 +2729,26 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 					return Status::InvalidAml;
 				}
 
-				auto copy = package->data->elements[index];
-				ref->data = Ref {.type = Ref::RefOf, .inner {move(copy)}};
+				if (!package->materialize()) {
+					return Status::NoMemory;
+				}
+				// the package is unshared and packed elements are boxed by the first store through a reference
+				auto element = ObjectRef::empty();
+				if (package->data->integers) {
+					element = new_temp();
+					if (!element) {
+						return Status::NoMemory;
+					}
+					element->data = package->data->integers[index];
+				}
+				else {
+					element = package->data->elements[index];
+				}
+				ref->data = Ref {
+					.type = Ref::RefOf,
+					.inner {move(element)},
+					.owner {src},
+					.index = static_cast<uint32_t>(index)};
 			}
 			else {
 				return Status::InvalidAml;
@@ -2033,8 +2768,8 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		}
 		case OpHandler::Alias:
 		{
-			auto name = objects.pop().get_unsafe<String>();
-			auto src = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
+			auto src = objects.pop().get_unsafe<NamePath>();
 
 			auto* node = create_or_get_node(src, Context::SearchFlags::Search);
 			if (!node) {
@@ -2064,8 +2799,12 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				if (!obj) {
 					return Status::NoMemory;
 				}
-				src.mark_as_path();
-				obj->data = move(src);
+				String str;
+				if (!name_path_to_str(src, str)) {
+					return Status::NoMemory;
+				}
+				str.mark_as_path();
+				obj->data = move(str);
 				new_node->object = move(obj);
 				new_node->object->node = new_node;
 			}
@@ -2074,7 +2813,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::Scope:
 		case OpHandler::Device:
 		{
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 			auto pkg_len = objects.pop().get_unsafe<PkgLength>();
 			uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
 
@@ -2133,6 +2872,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				new_frame->objects_at_start = objects.size();
 				new_frame->need_result = false;
 				new_frame->is_method = false;
+				new_frame->verified = frame.verified;
 				new_frame->type = Frame::Scope;
 
 				current_scope = node;
@@ -2150,7 +2890,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::Mutex:
 		{
 			auto flags = objects.pop().get_unsafe<PkgLength>().len;
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 
 			auto* node = create_or_get_node(name, Context::SearchFlags::Create);
 			if (!node) {
@@ -2181,7 +2921,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		}
 		case OpHandler::CreateField:
 		{
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 			auto num_bits_orig = pop_and_unwrap_obj();
 			auto bit_index_orig = pop_and_unwrap_obj();
 			auto src_orig = pop_and_unwrap_obj();
@@ -2246,7 +2986,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		}
 		case OpHandler::Event:
 		{
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 
 			auto* node = create_or_get_node(name, Context::SearchFlags::Create);
 			if (!node) {
@@ -2285,6 +3025,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 
 			uint64_t us = us_value->get_unsafe<uint64_t>();
 			qacpi_os_stall(us);
+			loop_timer_check = true;
 
 			break;
 		}
@@ -2298,21 +3039,45 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			}
 
 			uint64_t ms = ms_value->get_unsafe<uint64_t>();
-			qacpi_os_sleep(ms);
+			if (async) {
+				if (still_waiting(WaitCondition::Sleep, nullptr, ms)) {
+					if (!objects.push(move(ms_value))) {
+						return Status::NoMemory;
+					}
+					return Status::Suspended;
+				}
+			}
+			else {
+				qacpi_os_sleep(ms);
+			}
+			loop_timer_check = true;
 
 			break;
 		}
 		case OpHandler::Acquire:
 		{
-			uint16_t timeout_ms = objects.pop().get_unsafe<PkgLength>().len;
+			auto timeout = objects.pop().get_unsafe<PkgLength>();
+			uint16_t timeout_ms = timeout.len;
 			auto name = pop_and_unwrap_obj();
+			loop_timer_check = true;
 
 			if (auto mutex = name->get<Mutex>()) {
-				if (mutex->is_owned_by_thread()) {
+				if (mutex->is_owned_by(mutex_key())) {
 					++mutex->recursion;
 				}
 				else {
-					auto status = mutex->lock(timeout_ms);
+					auto status = mutex->lock(async ? 0 : timeout_ms, mutex_key());
+					if (async) {
+						if (status == Status::TimeOut &&
+							still_waiting(WaitCondition::Acquire, mutex->handle, timeout_ms == 0xFFFF ? UINT64_MAX : timeout_ms)) {
+							if (!objects.push(move(name)) || !objects.push(move(timeout))) {
+								return Status::NoMemory;
+							}
+							return Status::Suspended;
+						}
+						wait.type = WaitCondition::None;
+					}
+
 					if (status == Status::TimeOut) {
 						if (need_result) {
 							ObjectRef obj;
@@ -2397,8 +3162,21 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				timeout_ms = 0xFFFF;
 			}
 
+			loop_timer_check = true;
+
 			if (auto event = name->get<Event>()) {
-				auto status = event->wait(timeout_ms);
+				auto status = event->wait(async ? 0 : timeout_ms);
+				if (async) {
+					if (status == Status::TimeOut &&
+						still_waiting(WaitCondition::Wait, event->handle, timeout_ms == 0xFFFF ? UINT64_MAX : timeout_ms)) {
+						if (!objects.push(move(name)) || !objects.push(move(timeout_value))) {
+							return Status::NoMemory;
+						}
+						return Status::Suspended;
+					}
+					wait.type = WaitCondition::None;
+				}
+
 				if (status == Status::TimeOut) {
 					if (need_result) {
 						ObjectRef obj;
@@ -2453,7 +3231,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			auto name = pop_and_unwrap_obj();
 
 			if (auto mutex = name->get<Mutex>()) {
-				if (!mutex->is_owned_by_thread()) {
+				if (!mutex->is_owned_by(mutex_key())) {
 					return Status::InvalidAml;
 				}
 				if (mutex->recursion) {
@@ -2517,7 +3295,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				multiplier *= 10;
 			}
 
-			ObjectRef obj;
+			auto obj = new_temp();
 			if (!obj) {
 				return Status::NoMemory;
 			}
@@ -2556,7 +3334,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				offset += 4;
 			}
 
-			ObjectRef obj;
+			auto obj = new_temp();
 			if (!obj) {
 				return Status::NoMemory;
 			}
@@ -2698,10 +3476,10 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 					result = lhs % rhs;
 					break;
 				default:
-					break;
+					return Status::InternalError;
 			}
 
-			ObjectRef obj;
+			auto obj = new_temp();
 			if (!obj) {
 				return Status::NoMemory;
 			}
@@ -2738,10 +3516,10 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 					result = value->get_unsafe<uint64_t>() - 1;
 					break;
 				default:
-					break;
+					return Status::InternalError;
 			}
 
-			ObjectRef obj;
+			auto obj = new_temp();
 			if (!obj) {
 				return Status::NoMemory;
 			}
@@ -2849,10 +3627,10 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 					break;
 				}
 				default:
-					break;
+					return Status::InternalError;
 			}
 
-			ObjectRef obj;
+			auto obj = new_temp();
 			if (!obj) {
 				return Status::NoMemory;
 			}
@@ -2883,11 +3661,10 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				return status;
 			}
 
-			ObjectRef obj;
+			auto obj = context->get_constant(!value->get_unsafe<uint64_t>());
 			if (!obj) {
 				return Status::NoMemory;
 			}
-			obj->data = uint64_t {!value->get_unsafe<uint64_t>()};
 			if (!objects.push(move(obj))) {
 				return Status::NoMemory;
 			}
@@ -2936,7 +3713,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				return status;
 			}
 
-			uint64_t result;
+			uint64_t result = 0;
 			switch (block.block->handler) {
 				case OpHandler::LAnd:
 				{
@@ -3044,11 +3821,10 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 					break;
 			}
 
-			ObjectRef obj;
+			auto obj = context->get_constant(result);
 			if (!obj) {
 				return Status::NoMemory;
 			}
-			obj->data = result;
 			if (!objects.push(move(obj))) {
 				return Status::NoMemory;
 			}
@@ -3087,6 +3863,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 					new_frame->objects_at_start = objects.size();
 					new_frame->need_result = false;
 					new_frame->is_method = false;
+					new_frame->verified = frame.verified;
 					new_frame->type = Frame::If;
 				}
 			}
@@ -3095,10 +3872,10 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 
 				if (frame.ptr != frame.end && *frame.ptr == ElseOp) {
 					++frame.ptr;
-					CHECK_EOF;
+					CHECK_OPERAND_EOF;
 					auto first = *frame.ptr++;
 					uint8_t count = first >> 6;
-					CHECK_EOF_NUM(count);
+					CHECK_OPERAND_EOF_NUM(count);
 					frame.ptr += count;
 				}
 			}
@@ -3117,6 +3894,22 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::While:
 		{
 			auto pred_orig = pop_and_unwrap_obj();
+
+			if (block.block == &WHILE_PREDICATE_BLOCK) {
+				auto pred_val = ObjectRef::empty();
+				if (auto status = try_convert(pred_orig, pred_val, {ObjectType::Integer});
+					status != Status::Success) {
+					return status;
+				}
+
+				// frame.ptr is at the start of the body again if the loop continues
+				if (!pred_val->get_unsafe<uint64_t>()) {
+					frame.ptr = frame.end;
+					frame.exit_loop = true;
+				}
+				break;
+			}
+
 			auto pkg_len = objects.pop().get_unsafe<PkgLength>();
 			uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
 
@@ -3129,50 +3922,28 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			}
 
 			if (pred_val->get_unsafe<uint64_t>()) {
+				auto pred_start = pkg_len.start + (*pkg_len.start >> 6) + 1;
 				auto start = frame.ptr;
 				auto end = frame.ptr + len;
-				frame.ptr = pkg_len.start - 1;
-
-				auto prev_while_end = frame.prev_while_end;
-				auto prev_while_expiration = frame.prev_while_expiration;
+				frame.ptr = end;
 
 				auto* new_frame = frames.push();
 				if (!new_frame) {
 					return Status::NoMemory;
 				}
 
-				new_frame->start = start;
+				// the frame is kept for all iterations, start points to the predicate
+				new_frame->start = pred_start;
 				new_frame->end = end;
 				new_frame->ptr = start;
-				new_frame->parent_scope = nullptr;
+				new_frame->expiration_time = qacpi_os_timer() * 100 +
+					context->loop_timeout_seconds * (1000 * 1000 * 1000);
 				new_frame->objects_at_start = objects.size();
-
-				uint64_t current = qacpi_os_timer() * 100;
-
-				if (end == prev_while_end) {
-					if (current >= prev_while_expiration) {
-						LOG << "qacpi: loop timed out after "
-						    << context->loop_timeout_seconds
-						    << " seconds"
-						    << endlog;
-
-						if (auto status = unwind_stack(); status != Status::Success) {
-							return status;
-						}
-
-						break;
-					}
-
-					new_frame->expiration_time = prev_while_expiration;
-				}
-				else {
-					new_frame->expiration_time = current +
-						context->loop_timeout_seconds *
-						(1000 * 1000 * 1000);
-				}
-
+				new_frame->loop_iterations = 0;
 				new_frame->need_result = false;
 				new_frame->is_method = false;
+				new_frame->exit_loop = false;
+				new_frame->verified = frame.verified;
 				new_frame->type = Frame::While;
 			}
 			else {
@@ -3225,10 +3996,8 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 					if (frames.size() < 2) {
 						return Status::InvalidAml;
 					}
-					auto& other_frame = frames[frames.size() - 2];
-
-					other_frame.ptr = frame_iter.end;
 					frame_iter.ptr = frame_iter.end;
+					frame_iter.exit_loop = true;
 					break;
 				}
 			}
@@ -3281,7 +4050,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			auto len_value_orig = pop_and_unwrap_obj();
 			auto offset_value_orig = pop_and_unwrap_obj();
 			auto space = objects.pop().get_unsafe<PkgLength>().len;
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 
 			auto len_value = ObjectRef::empty();
 			auto offset_value = ObjectRef::empty();
@@ -3407,7 +4176,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::CreateDWordField:
 		case OpHandler::CreateQWordField:
 		{
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 			auto index_orig = pop_and_unwrap_obj();
 			auto src_orig = pop_and_unwrap_obj();
 
@@ -3504,7 +4273,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			auto list = objects.pop().get_unsafe<FieldList>();
 			// flags
 			objects.pop();
-			auto reg_name = objects.pop().get_unsafe<String>();
+			auto reg_name = objects.pop().get_unsafe<NamePath>();
 			// length
 			objects.pop();
 
@@ -3535,7 +4304,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		{
 			auto resource_order = objects.pop().get_unsafe<PkgLength>().len;
 			auto system_level = objects.pop().get_unsafe<PkgLength>().len;
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 			auto pkg_len = objects.pop().get_unsafe<PkgLength>();
 			uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
 
@@ -3584,6 +4353,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				new_frame->objects_at_start = objects.size();
 				new_frame->need_result = false;
 				new_frame->is_method = false;
+				new_frame->verified = frame.verified;
 				new_frame->type = Frame::Scope;
 
 				current_scope = node;
@@ -3596,7 +4366,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			auto processor_block_len = objects.pop().get_unsafe<PkgLength>().len;
 			auto processor_block_addr = objects.pop().get_unsafe<PkgLength>().len;
 			auto processor_id = objects.pop().get_unsafe<PkgLength>().len;
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 			auto pkg_len = objects.pop().get_unsafe<PkgLength>();
 			uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
 
@@ -3646,6 +4416,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				new_frame->objects_at_start = objects.size();
 				new_frame->need_result = false;
 				new_frame->is_method = false;
+				new_frame->verified = frame.verified;
 				new_frame->type = Frame::Scope;
 
 				current_scope = node;
@@ -3700,7 +4471,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		}
 		case OpHandler::ThermalZone:
 		{
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 			auto pkg_len = objects.pop().get_unsafe<PkgLength>();
 			uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
 
@@ -3744,6 +4515,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				new_frame->objects_at_start = objects.size();
 				new_frame->need_result = false;
 				new_frame->is_method = false;
+				new_frame->verified = frame.verified;
 				new_frame->type = Frame::Scope;
 
 				current_scope = node;
@@ -3807,7 +4579,8 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				if (!obj) {
 					return Status::NoMemory;
 				}
-				obj->data = uint64_t {name->data.index() - 1};
+				// ObjectType numbers the types from 0 for Uninitialized
+				obj->data = static_cast<uint64_t>(name->type()) - 1;
 
 				if (!objects.push(move(obj))) {
 					return Status::NoMemory;
@@ -3969,7 +4742,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			auto oem_table_id_obj = pop_and_unwrap_obj();
 			auto oem_id_obj = pop_and_unwrap_obj();
 			auto signature_obj = pop_and_unwrap_obj();
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 
 			auto* node = create_or_get_node(name, Context::SearchFlags::Create);
 			if (!node) {
@@ -4038,8 +4811,8 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			auto list = objects.pop().get_unsafe<FieldList>();
 			// flags
 			objects.pop();
-			auto data_name = objects.pop().get_unsafe<String>();
-			auto index_name = objects.pop().get_unsafe<String>();
+			auto data_name = objects.pop().get_unsafe<NamePath>();
+			auto index_name = objects.pop().get_unsafe<NamePath>();
 			// length
 			objects.pop();
 
@@ -4083,8 +4856,8 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			// flags
 			objects.pop();
 			auto selection = objects.pop().get_unsafe<ObjectRef>();
-			auto bank_name = objects.pop().get_unsafe<String>();
-			auto reg_name = objects.pop().get_unsafe<String>();
+			auto bank_name = objects.pop().get_unsafe<NamePath>();
+			auto reg_name = objects.pop().get_unsafe<NamePath>();
 			// length
 			objects.pop();
 
@@ -4160,6 +4933,10 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				break;
 			}
 
+			if (!pkg->materialize()) {
+				return Status::NoMemory;
+			}
+
 			auto operand1 = ObjectRef::empty();
 			if (auto status = try_convert(
 				orig_operand1,
@@ -4191,17 +4968,23 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			uint64_t ret_index = 0xFFFFFFFFFFFFFFFF;
 
 			for (uint32_t i = start_index; i < pkg->data->element_count; ++i) {
-				auto& element = pkg->data->elements[i];
-				auto converted = ObjectRef::empty();
-				auto status = try_convert(
-					element,
-					converted,
-					{ObjectType::Integer});
-				if (status == Status::InvalidArgs) {
-					continue;
+				uint64_t value;
+				if (pkg->data->integers) {
+					value = pkg->data->integers[i];
 				}
-				else if (status != Status::Success) {
-					return status;
+				else {
+					auto converted = ObjectRef::empty();
+					auto status = try_convert(
+						pkg->data->elements[i],
+						converted,
+						{ObjectType::Integer});
+					if (status == Status::InvalidArgs) {
+						continue;
+					}
+					else if (status != Status::Success) {
+						return status;
+					}
+					value = converted->get_unsafe<uint64_t>();
 				}
 
 				bool match1;
@@ -4210,19 +4993,19 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 						match1 = true;
 						break;
 					case 1:
-						match1 = converted->get_unsafe<uint64_t>() == operand1->get_unsafe<uint64_t>();
+						match1 = value == operand1->get_unsafe<uint64_t>();
 						break;
 					case 2:
-						match1 = converted->get_unsafe<uint64_t>() <= operand1->get_unsafe<uint64_t>();
+						match1 = value <= operand1->get_unsafe<uint64_t>();
 						break;
 					case 3:
-						match1 = converted->get_unsafe<uint64_t>() < operand1->get_unsafe<uint64_t>();
+						match1 = value < operand1->get_unsafe<uint64_t>();
 						break;
 					case 4:
-						match1 = converted->get_unsafe<uint64_t>() >= operand1->get_unsafe<uint64_t>();
+						match1 = value >= operand1->get_unsafe<uint64_t>();
 						break;
 					case 5:
-						match1 = converted->get_unsafe<uint64_t>() > operand1->get_unsafe<uint64_t>();
+						match1 = value > operand1->get_unsafe<uint64_t>();
 						break;
 					default:
 						return Status::InvalidAml;
@@ -4238,19 +5021,19 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 						match2 = true;
 						break;
 					case 1:
-						match2 = converted->get_unsafe<uint64_t>() == operand2->get_unsafe<uint64_t>();
+						match2 = value == operand2->get_unsafe<uint64_t>();
 						break;
 					case 2:
-						match2 = converted->get_unsafe<uint64_t>() <= operand2->get_unsafe<uint64_t>();
+						match2 = value <= operand2->get_unsafe<uint64_t>();
 						break;
 					case 3:
-						match2 = converted->get_unsafe<uint64_t>() < operand2->get_unsafe<uint64_t>();
+						match2 = value < operand2->get_unsafe<uint64_t>();
 						break;
 					case 4:
-						match2 = converted->get_unsafe<uint64_t>() >= operand2->get_unsafe<uint64_t>();
+						match2 = value >= operand2->get_unsafe<uint64_t>();
 						break;
 					case 5:
-						match2 = converted->get_unsafe<uint64_t>() > operand2->get_unsafe<uint64_t>();
+						match2 = value > operand2->get_unsafe<uint64_t>();
 						break;
 					default:
 						return Status::InvalidAml;
@@ -4273,7 +5056,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 		case OpHandler::Load:
 		{
 			auto target = pop_and_unwrap_obj();
-			auto name = objects.pop().get_unsafe<String>();
+			auto name = objects.pop().get_unsafe<NamePath>();
 
 			auto node = create_or_get_node(name, Context::SearchFlags::Search);
 			auto obj = node->object;
@@ -4356,6 +5139,9 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 
 			auto buf_size = buf.size();
 			auto ptr = buf.leak();
+			if (!ptr) {
+				return Status::NoMemory;
+			}
 
 			auto* hdr = reinterpret_cast<SdtHeader*>(ptr);
 			uint32_t size = hdr->length - sizeof(SdtHeader);
@@ -4364,7 +5150,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			void* override {};
 			bool allow = !context->table_install_handler || context->table_install_handler(hdr, override);
 			if (override) {
-				qacpi_os_free(ptr, buf_size);
+				deallocate(ptr, buf_size);
 
 				hdr = static_cast<SdtHeader*>(override);
 				if (!buf.init(override, hdr->length)) {
@@ -4372,6 +5158,9 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 				}
 
 				ptr = buf.leak();
+				if (!ptr) {
+					return Status::NoMemory;
+				}
 				hdr = reinterpret_cast<SdtHeader*>(ptr);
 				size = hdr->length - sizeof(SdtHeader);
 				data = reinterpret_cast<const uint8_t*>(&hdr[1]);
@@ -4382,7 +5171,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			    hdr->signature[2] != 'D' ||
 			    hdr->signature[3] != 'T' ||
 				!allow) {
-				qacpi_os_free(ptr, buf_size);
+				deallocate(ptr, buf_size);
 
 				ObjectRef res;
 				if (!res) {
@@ -4406,7 +5195,7 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 
 			auto* new_frame = frames.push();
 			if (!new_frame) {
-				qacpi_os_free(ptr, buf_size);
+				deallocate(ptr, buf_size);
 				return Status::NoMemory;
 			}
 			new_frame->start = data;
@@ -4418,17 +5207,21 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			new_frame->data_buf_size = buf_size;
 			new_frame->need_load_result = need_result;
 			new_frame->is_method = true;
+			new_frame->verified = verify_aml(data, size);
 			new_frame->type = Frame::Scope;
 
 			current_scope = context->root;
 
 			auto* method_frame = method_frames.push();
-			if (!method_frame) {
-				qacpi_os_free(ptr, buf_size);
+			if (!method_frame || !method_frame->init_load_table()) {
+				if (method_frame) {
+					method_frames.pop_discard();
+				}
+				deallocate(ptr, buf_size);
 				frames.pop_discard();
 				return Status::NoMemory;
 			}
-			method_frame->table_target = move(target);
+			method_frame->load_table->table_target = move(target);
 
 			break;
 		}
@@ -4578,22 +5371,26 @@ Status Interpreter::handle_op(Interpreter::Frame& frame, const OpBlockCtx& block
 			new_frame->objects_at_start = objects.size();
 			new_frame->need_load_result = need_result;
 			new_frame->is_method = true;
+			new_frame->verified = verify_aml(data, size);
 			new_frame->type = Frame::Scope;
 
 			current_scope = root_node;
 
 			auto* method_frame = method_frames.push();
-			if (!method_frame) {
+			if (!method_frame || !method_frame->init_load_table()) {
+				if (method_frame) {
+					method_frames.pop_discard();
+				}
 				if (table) {
 					table->unref();
 				}
 				frames.pop_discard();
 				return Status::NoMemory;
 			}
-			method_frame->load_table_param = move(param_data_obj);
-			method_frame->load_table_param_path = move(param_path);
-			method_frame->load_table_root_path = move(root_path);
-			method_frame->table = table;
+			method_frame->load_table->param = move(param_data_obj);
+			method_frame->load_table->param_path = move(param_path);
+			method_frame->load_table->root_path = move(root_path);
+			method_frame->load_table->table = table;
 
 			break;
 		}
@@ -4761,7 +5558,40 @@ else { \
 } \
 }
 
+// Operands are dispatched on (op, processed), either through a switch or with
+// QACPI_THREADED_DISPATCH through a computed goto into a label table.
+#ifdef QACPI_THREADED_DISPATCH
+#define OP_DISPATCH(op, processed) goto *OP_LABELS[static_cast<uint32_t>(op) * 2 + (processed)];
+#define OP_START(op) op_start_##op:
+#define OP_DONE(op) op_done_##op:
+#define OP_LABEL_PAIR(op) &&op_start_##op, &&op_done_##op
+#else
+#define OP_DISPATCH(op, processed) switch (static_cast<uint32_t>(op) * 2 + (processed))
+#define OP_START(op) case static_cast<uint32_t>(Op::op) * 2:
+#define OP_DONE(op) case static_cast<uint32_t>(Op::op) * 2 + 1:
+#endif
+
 Status Interpreter::parse() {
+#ifdef QACPI_THREADED_DISPATCH
+	static void* const OP_LABELS[] {
+		OP_LABEL_PAIR(PkgLength),
+		OP_LABEL_PAIR(TermArg),
+		OP_LABEL_PAIR(SuperName),
+		OP_LABEL_PAIR(SuperNameUnresolved),
+		OP_LABEL_PAIR(Byte),
+		OP_LABEL_PAIR(Word),
+		OP_LABEL_PAIR(DWord),
+		OP_LABEL_PAIR(NameString),
+		OP_LABEL_PAIR(MethodArgs),
+		OP_LABEL_PAIR(PkgElements),
+		OP_LABEL_PAIR(VarPkgElements),
+		OP_LABEL_PAIR(StartFieldList),
+		OP_LABEL_PAIR(FieldList),
+		OP_LABEL_PAIR(CallHandler)
+	};
+	static_assert(sizeof(OP_LABELS) / sizeof(*OP_LABELS) == (static_cast<uint32_t>(Op::CallHandler) + 1) * 2);
+#endif
+
 	while (true) {
 		if (frames.is_empty()) {
 			if (objects.size() != 0 && objects.size() != 1) {
@@ -4782,25 +5612,55 @@ Status Interpreter::parse() {
 				if (frame.type == Frame::Scope) {
 					current_scope = frame.parent_scope;
 				}
-				else if (frame.type == Frame::While) {
-					frames[frame_index - 1].prev_while_end = frame.end;
-					frames[frame_index - 1].prev_while_expiration = frame.expiration_time;
+				else if (frame.type == Frame::While && !frame.exit_loop) {
+					if (budgeted && out_of_budget()) {
+						return Status::Suspended;
+					}
+					if (++frame.loop_iterations % LOOP_TIMER_INTERVAL == 0 || loop_timer_check) {
+						loop_timer_check = false;
+						if (qacpi_os_timer() * 100 >= frame.expiration_time) {
+							LOG << "qacpi: loop timed out after "
+							    << context->loop_timeout_seconds
+							    << " seconds"
+							    << endlog;
+
+							if (auto status = unwind_stack(); status != Status::Success) {
+								return status;
+							}
+							continue;
+						}
+					}
+
+					frame.ptr = frame.start;
+					if (!frame.op_blocks.push({
+						.block = &WHILE_PREDICATE_BLOCK,
+						.objects_at_start = static_cast<uint32_t>(objects.size()),
+						.ip = 0,
+						.processed = false,
+						.need_result = true,
+						.as_ref = false
+					})) {
+						return Status::NoMemory;
+					}
+					continue;
 				}
 				if (frame.is_method) {
 					auto& method_frame = method_frames.back();
-					if (method_frame.table_target) {
+					auto* load_table = method_frame.load_table;
+					if (load_table && load_table->table_target) {
 						ObjectRef obj;
 						if (!obj) {
 							return Status::NoMemory;
 						}
 						obj->data = uint64_t {0xFFFFFFFFFFFFFFFF};
 
-						if (auto status = store_to_target(method_frame.table_target, obj);
+						if (auto status = store_to_target(load_table->table_target, obj);
 							status != Status::Success) {
 							if (frames.size() != 1) {
-								method_frame.table_target = ObjectRef::empty();
+								load_table->table_target = ObjectRef::empty();
 								if (frame.data_buf) {
-									qacpi_os_free(frame.data_buf, frame.data_buf_size);
+									context->forget_method_bodies(frame.data_buf, frame.data_buf_size);
+									deallocate(frame.data_buf, frame.data_buf_size);
 								}
 								method_frames.pop_discard();
 								frames.pop_discard();
@@ -4848,10 +5708,10 @@ Status Interpreter::parse() {
 							}
 						}
 					}
-					else if (method_frame.load_table_param) {
+					else if (load_table && load_table->param) {
 						String real_path {};
 
-						auto& path = method_frame.load_table_param_path;
+						auto& path = load_table->param_path;
 						if (path.size() > 0) {
 							if (path.size() > 0 && (path.data()[0] == '\\' || path.data()[0] == '^')) {
 								if (!real_path.init(path.data(), path.size())) {
@@ -4860,8 +5720,8 @@ Status Interpreter::parse() {
 							}
 							else {
 								StringView root_path;
-								if (method_frame.load_table_root_path.size()) {
-									root_path = method_frame.load_table_root_path;
+								if (load_table->root_path.size()) {
+									root_path = load_table->root_path;
 								}
 								else {
 									root_path = "\\";
@@ -4890,11 +5750,11 @@ Status Interpreter::parse() {
 							if (!node) {
 								if (context->log_level >= LogLevel::Error) {
 									LOG << "qacpi error: unresolved path for LoadTable parameter: "
-									    << method_frame.load_table_param_path
+									    << load_table->param_path
 									    << endlog;
 								}
 								if (frames.size() != 1) {
-									method_frame.load_table_param = ObjectRef::empty();
+									load_table->param = ObjectRef::empty();
 									method_frames.pop_discard();
 									frames.pop_discard();
 									unwind_stack();
@@ -4907,13 +5767,13 @@ Status Interpreter::parse() {
 							else if (!node->object) {
 								if (context->log_level >= LogLevel::Error) {
 									LOG << "qacpi internal error: node "
-									    << method_frame.load_table_param_path
+									    << load_table->param_path
 									    << " lacks an object (required by LoadTable)"
 									    << endlog;
 								}
 
 								if (frames.size() != 1) {
-									method_frame.load_table_param = ObjectRef::empty();
+									load_table->param = ObjectRef::empty();
 									method_frames.pop_discard();
 									frames.pop_discard();
 									unwind_stack();
@@ -4924,10 +5784,10 @@ Status Interpreter::parse() {
 								}
 							}
 
-							if (auto status = store_to_target(node->object, method_frame.load_table_param);
+							if (auto status = store_to_target(node->object, load_table->param);
 								status != Status::Success) {
 								if (frames.size() != 1) {
-									method_frame.load_table_param = ObjectRef::empty();
+									load_table->param = ObjectRef::empty();
 									method_frames.pop_discard();
 									frames.pop_discard();
 									unwind_stack();
@@ -4968,11 +5828,10 @@ Status Interpreter::parse() {
 
 					method_frames.pop_discard();
 					if (frame.need_result) {
-						ObjectRef obj;
+						auto obj = context->get_constant(0);
 						if (!obj) {
 							return Status::NoMemory;
 						}
-						obj->data = uint64_t {0};
 
 						if (!objects.push(move(obj))) {
 							return Status::NoMemory;
@@ -4984,16 +5843,32 @@ Status Interpreter::parse() {
 				continue;
 			}
 
-			CHECK_EOF;
-			auto byte = *frame.ptr++;
+			if (budgeted && frame.type != Frame::Package && out_of_budget()) {
+				return Status::Suspended;
+			}
+
+			if (frame.type == Frame::Package) {
+				uint64_t value;
+				if (fold_integer(frame, value)) {
+					if (auto status = push_integer(value); status != Status::Success) {
+						return status;
+					}
+					continue;
+				}
+			}
 
 			const OpBlock* block;
-			if (byte == 0x5B) {
-				CHECK_EOF;
-				byte = *frame.ptr++;
-				block = &EXT_OPS[byte];
+			if (auto status = decode_op(frame, block); status != Status::Success) {
+				if (frames.size() != 1) {
+					unwind_stack();
+					continue;
+				}
+				else {
+					return status;
+				}
 			}
-			else if (is_name_char(byte)) {
+
+			if (!block) {
 				auto is_package = frame.type == Frame::Package;
 				if (auto status = handle_name(frame, is_package, is_package); status != Status::Success) {
 					if (frames.size() != 1) {
@@ -5006,12 +5881,9 @@ Status Interpreter::parse() {
 				}
 				continue;
 			}
-			else {
-				block = &OPS[byte];
-			}
 
 			if (block->handler == OpHandler::None) {
-				LOG << "qacpi internal error: unimplemented op " << byte << endlog;
+				LOG << "qacpi internal error: unimplemented op " << *(frame.ptr - 1) << endlog;
 				return Status::Unsupported;
 			}
 
@@ -5030,143 +5902,233 @@ Status Interpreter::parse() {
 		auto& block = frame.op_blocks.back();
 		auto op = block.block->ops[block.ip];
 
-		if (block.processed) {
-			++block.ip;
-			block.processed = false;
-			switch (op) {
-				case Op::PkgLength:
-				case Op::Byte:
-				case Op::Word:
-				case Op::DWord:
-				{
-					++block.objects_at_start;
-					if (objects.size() != block.objects_at_start) {
-						if (frames.size() != 1) {
-							unwind_stack();
-							continue;
-						}
-						else {
-							return Status::InvalidAml;
-						}
+		OP_DISPATCH(op, block.processed) {
+			OP_DONE(PkgLength)
+			OP_DONE(Byte)
+			OP_DONE(Word)
+			OP_DONE(DWord)
+			{
+				++block.ip;
+				block.processed = false;
+				++block.objects_at_start;
+				if (objects.size() != block.objects_at_start) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
 					}
-					if (!objects.back().get<PkgLength>()) {
-						__builtin_trap();
+					else {
+						return Status::InvalidAml;
 					}
-
-					break;
 				}
-				case Op::NameString:
-				{
-					++block.objects_at_start;
-					if (objects.size() != block.objects_at_start) {
-						if (frames.size() != 1) {
-							unwind_stack();
-							continue;
-						}
-						else {
-							return Status::InvalidAml;
-						}
+				if (!objects.back().get<PkgLength>()) {
+					__builtin_trap();
+				}
+
+				continue;
+			}
+			OP_DONE(NameString)
+			{
+				++block.ip;
+				block.processed = false;
+				++block.objects_at_start;
+				if (objects.size() != block.objects_at_start) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
 					}
-					if (!objects.back().get<String>()) {
-						__builtin_trap();
+					else {
+						return Status::InvalidAml;
 					}
-
-					break;
 				}
-				case Op::PkgElements:
-				case Op::VarPkgElements:
-					break;
-				case Op::TermArg:
-				case Op::SuperName:
-				case Op::SuperNameUnresolved:
-					++block.objects_at_start;
-					if (objects.size() != block.objects_at_start) {
-						if (frames.size() != 1) {
-							unwind_stack();
-							continue;
-						}
-						else {
-							return Status::InvalidAml;
-						}
+				if (!objects.back().get<NamePath>()) {
+					__builtin_trap();
+				}
+
+				continue;
+			}
+			OP_DONE(TermArg)
+			OP_DONE(SuperName)
+			OP_DONE(SuperNameUnresolved)
+				++block.ip;
+				block.processed = false;
+				++block.objects_at_start;
+				if (objects.size() != block.objects_at_start) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
 					}
-					if (!objects.back().get<ObjectRef>()) {
-						__builtin_trap();
+					else {
+						return Status::InvalidAml;
 					}
+				}
+				if (!objects.back().get<ObjectRef>()) {
+					__builtin_trap();
+				}
 
-					break;
-				case Op::MethodArgs:
-				{
-					auto& args = objects[block.objects_at_start].get_unsafe<MethodArgs>();
-					if (args.remaining || objects.size() != block.objects_at_start + 1 + args.method->arg_count) {
-						if (frames.size() != 1) {
-							unwind_stack();
-							continue;
-						}
-						else {
-							return Status::InvalidAml;
-						}
+				continue;
+			OP_DONE(MethodArgs)
+			{
+				++block.ip;
+				block.processed = false;
+				auto& args = objects[block.objects_at_start].get_unsafe<MethodArgs>();
+				if (args.remaining || objects.size() != block.objects_at_start + 1 + args.method->arg_count) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
 					}
-					break;
-				}
-				case Op::FieldList:
-				{
-					auto& list = objects.back().get_unsafe<FieldList>();
-					if (list.frame.ptr != list.frame.end) {
-						if (frames.size() != 1) {
-							unwind_stack();
-							continue;
-						}
-						else {
-							return Status::InvalidAml;
-						}
+					else {
+						return Status::InvalidAml;
 					}
-					break;
 				}
-				case Op::StartFieldList:
-				case Op::CallHandler:
-					break;
+				continue;
 			}
-		}
-		else if (op == Op::CallHandler) {
-			++block.ip;
-			if (auto status = handle_op(frame, block, block.need_result); status != Status::Success) {
-				if (frames.size() != 1) {
-					unwind_stack();
-					continue;
-				}
-				else {
-					return status;
+			OP_DONE(FieldList)
+			{
+				++block.ip;
+				block.processed = false;
+				auto& list = objects.back().get_unsafe<FieldList>();
+				if (list.frame.ptr != list.frame.end) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
+					}
+					else {
+						return Status::InvalidAml;
+					}
 				}
+				continue;
 			}
-			frames[frame_index].op_blocks.pop_discard();
-		}
-		else {
-			block.processed = true;
+			OP_DONE(PkgElements)
+			OP_DONE(VarPkgElements)
+			OP_DONE(StartFieldList)
+			OP_DONE(CallHandler)
+				++block.ip;
+				block.processed = false;
+				continue;
 
-			switch (op) {
-				case Op::PkgLength:
-				{
-					PkgLength res {};
-					if (auto status = parse_pkg_len(frame, res); status != Status::Success) {
-						if (frames.size() != 1) {
-							unwind_stack();
-							continue;
-						}
-						else {
-							return status;
-						}
+			OP_START(CallHandler)
+				++block.ip;
+				if (auto status = handle_op(frame, block, block.need_result); status != Status::Success) {
+					// a blocking op of an async evaluation left its operands to be run again on resume
+					if (status == Status::Suspended) {
+						--block.ip;
+						return status;
+					}
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
+					}
+					else {
+						return status;
+					}
+				}
+				// the handler may have popped the frame (e.g. Return or Break)
+				if (frame_index < frames.size()) {
+					frames[frame_index].op_blocks.pop_discard();
+				}
+				continue;
+			OP_START(PkgLength)
+			{
+				block.processed = true;
+				PkgLength res {};
+				if (auto status = decode_pkg_len(frame, res); status != Status::Success) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
 					}
+					else {
+						return status;
+					}
+				}
 
-					if (!objects.push(move(res))) {
-						return Status::NoMemory;
+				if (!objects.push(move(res))) {
+					return Status::NoMemory;
+				}
+
+				continue;
+			}
+			OP_START(NameString)
+			{
+				block.processed = true;
+				NamePath path;
+				if (auto status = parse_name_path(frame, path); status != Status::Success) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
+					}
+					else {
+						return status;
 					}
+				}
+				if (!objects.push(move(path))) {
+					return Status::NoMemory;
+				}
+				continue;
+			}
+			OP_START(Byte)
+			{
+				block.processed = true;
+				CHECK_OPERAND_EOF;
+				auto byte = *frame.ptr++;
 
-					break;
+				if (!objects.push(PkgLength {
+					.start = frame.ptr,
+					.len = byte
+				})) {
+					return Status::NoMemory;
 				}
-				case Op::NameString:
-				{
-					String str;
-					if (auto status = parse_name_str(frame, str); status != Status::Success) {
+
+				continue;
+			}
+			OP_START(Word)
+			{
+				block.processed = true;
+				CHECK_OPERAND_EOF_NUM(2);
+				uint16_t value;
+				memcpy(&value, frame.ptr, 2);
+				frame.ptr += 2;
+
+				if (!objects.push(PkgLength {
+					.start = frame.ptr,
+					.len = value
+				})) {
+					return Status::NoMemory;
+				}
+
+				continue;
+			}
+			OP_START(DWord)
+			{
+				block.processed = true;
+				CHECK_OPERAND_EOF_NUM(4);
+				uint32_t value;
+				memcpy(&value, frame.ptr, 4);
+				frame.ptr += 4;
+
+				if (!objects.push(PkgLength {
+					.start = frame.ptr,
+					.len = value
+				})) {
+					return Status::NoMemory;
+				}
+
+				continue;
+			}
+			OP_START(PkgElements)
+			OP_START(VarPkgElements)
+			{
+				block.processed = true;
+				auto pkg_len = objects[block.objects_at_start - 2].get_unsafe<PkgLength>();
+				uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
+
+				CHECK_EOF_NUM(len);
+
+				if (op == Op::VarPkgElements) {
+					auto num_elements_obj = pop_and_unwrap_obj();
+
+					auto obj = ObjectRef::empty();
+					if (auto status = try_convert(num_elements_obj, obj, {ObjectType::Integer});
+						status != Status::Success) {
 						if (frames.size() != 1) {
 							unwind_stack();
 							continue;
@@ -5175,293 +6137,269 @@ Status Interpreter::parse() {
 							return status;
 						}
 					}
-					if (!objects.push(move(str))) {
-						return Status::NoMemory;
-					}
-					break;
-				}
-				case Op::Byte:
-				{
-					CHECK_EOF;
-					auto byte = *frame.ptr++;
-
 					if (!objects.push(PkgLength {
-						.start = frame.ptr,
-						.len = byte
+						.start = nullptr,
+						.len = static_cast<uint32_t>(obj->get_unsafe<uint64_t>())
 					})) {
 						return Status::NoMemory;
 					}
-
-					break;
 				}
-				case Op::Word:
-				{
-					CHECK_EOF_NUM(2);
-					uint16_t value;
-					memcpy(&value, frame.ptr, 2);
-					frame.ptr += 2;
 
-					if (!objects.push(PkgLength {
-						.start = frame.ptr,
-						.len = value
-					})) {
-						return Status::NoMemory;
-					}
-
-					break;
-				}
-				case Op::DWord:
-				{
-					CHECK_EOF_NUM(4);
-					uint32_t value;
-					memcpy(&value, frame.ptr, 4);
-					frame.ptr += 4;
+				auto start = frame.ptr;
+				auto end = frame.ptr + len;
+				frame.ptr += len;
 
+				// the handler makes a lazy package if the elements are replaced by their count
+				uint32_t init_count;
+				if (can_defer_package() && scan_package_literal(start, len, init_count,
+					[](void* arg, const NamePath& path) {
+						return static_cast<Interpreter*>(arg)->create_or_get_node(
+							path, Context::SearchFlags::Search) != nullptr;
+					}, this)) {
 					if (!objects.push(PkgLength {
-						.start = frame.ptr,
-						.len = value
+						.start = start,
+						.len = init_count
 					})) {
 						return Status::NoMemory;
 					}
+					continue;
+				}
 
-					break;
+				auto* new_frame = frames.push();
+				if (!new_frame) {
+					return Status::NoMemory;
 				}
-				case Op::PkgElements:
-				case Op::VarPkgElements:
-				{
-					auto pkg_len = objects[block.objects_at_start - 2].get_unsafe<PkgLength>();
-					uint32_t len = pkg_len.len - (frame.ptr - pkg_len.start);
 
-					CHECK_EOF_NUM(len);
+				new_frame->start = start;
+				new_frame->end = end;
+				new_frame->ptr = start;
+				new_frame->parent_scope = current_scope;
+				new_frame->objects_at_start = objects.size();
+				new_frame->need_result = true;
+				new_frame->is_method = false;
+				new_frame->verified = frame.verified;
+				new_frame->type = Frame::Package;
 
-					if (op == Op::VarPkgElements) {
-						auto num_elements_obj = pop_and_unwrap_obj();
+				continue;
+			}
+			OP_START(MethodArgs)
+			{
+				auto& args = objects[block.objects_at_start].get_unsafe<MethodArgs>();
+				if (!args.remaining) {
+					block.processed = true;
+					continue;
+				}
+				--args.remaining;
+				goto method_arg;
+			}
+			OP_START(TermArg)
+			OP_START(SuperName)
+			OP_START(SuperNameUnresolved)
+				block.processed = true;
+				if (block.block->handler == OpHandler::Name && op == Op::TermArg) {
+					uint64_t value;
+					if (fold_integer(frame, value)) {
+						if (auto status = push_integer(value); status != Status::Success) {
+							return status;
+						}
+						continue;
+					}
+				}
+			method_arg:
+			{
+				const OpBlock* new_block;
+				if (auto status = decode_op(frame, new_block); status != Status::Success) {
+					if (frames.size() != 1) {
+						unwind_stack();
+						continue;
+					}
+					else {
+						return status;
+					}
+				}
 
-						auto obj = ObjectRef::empty();
-						if (auto status = try_convert(num_elements_obj, obj, {ObjectType::Integer});
-							status != Status::Success) {
-							if (frames.size() != 1) {
-								unwind_stack();
-								continue;
-							}
-							else {
-								return status;
+				if (!new_block) {
+					if (auto status = handle_name(
+						frame,
+						true, op == Op::SuperName || op == Op::SuperNameUnresolved);
+						status != Status::Success) {
+						if (status == Status::NotFound && op == Op::SuperNameUnresolved) {
+							auto obj = ObjectRef::empty();
+							if (!objects.push(move(obj))) {
+								return Status::NoMemory;
 							}
+							continue;
 						}
-						if (!objects.push(PkgLength {
-							.start = nullptr,
-							.len = static_cast<uint32_t>(obj->get_unsafe<uint64_t>())
-						})) {
-							return Status::NoMemory;
+						if (frames.size() != 1) {
+							unwind_stack();
+							continue;
+						}
+						else {
+							return status;
 						}
 					}
+					continue;
+				}
 
-					auto start = frame.ptr;
-					auto end = frame.ptr + len;
-					frame.ptr += len;
+				if (new_block->handler == OpHandler::None) {
+					LOG << "qacpi internal error: unimplemented op " << *(frame.ptr - 1) << endlog;
+					return Status::Unsupported;
+				}
 
-					auto* new_frame = frames.push();
-					if (!new_frame) {
-						return Status::NoMemory;
-					}
+				if (!frame.op_blocks.push({
+					.block = new_block,
+					.objects_at_start = static_cast<uint32_t>(objects.size()),
+					.ip = 0,
+					.processed = false,
+					.need_result = true,
+					.as_ref = op == Op::SuperName
+				})) {
+					return Status::NoMemory;
+				}
 
-					new_frame->start = start;
-					new_frame->end = end;
-					new_frame->ptr = start;
-					new_frame->parent_scope = current_scope;
-					new_frame->objects_at_start = objects.size();
-					new_frame->need_result = true;
-					new_frame->is_method = false;
-					new_frame->type = Frame::Package;
+				continue;
+			}
+			OP_START(StartFieldList)
+			{
+				block.processed = true;
+				uint32_t remaining_data;
+				uint8_t flags = objects[objects.size() - 1].get_unsafe<PkgLength>().len;
+				decltype(Field::Normal) type;
 
-					break;
+				if (block.block->handler == OpHandler::Field) {
+					auto len = objects[objects.size() - 3].get_unsafe<PkgLength>();
+					remaining_data = len.len - (frame.ptr - len.start);
+					type = Field::Normal;
 				}
-				case Op::MethodArgs:
-				{
-					auto& args = objects[block.objects_at_start].get_unsafe<MethodArgs>();
-					if (!args.remaining) {
-						break;
-					}
-					else {
-						--args.remaining;
-						block.processed = false;
-					}
-
-					[[fallthrough]];
+				else if (block.block->handler == OpHandler::IndexField) {
+					auto len = objects[objects.size() - 4].get_unsafe<PkgLength>();
+					remaining_data = len.len - (frame.ptr - len.start);
+					type = Field::Index;
+				}
+				else if (block.block->handler == OpHandler::BankField) {
+					auto len = objects[objects.size() - 5].get_unsafe<PkgLength>();
+					remaining_data = len.len - (frame.ptr - len.start);
+					type = Field::Bank;
+				}
+				else {
+					__builtin_unreachable();
 				}
-				case Op::TermArg:
-				case Op::SuperName:
-				case Op::SuperNameUnresolved:
-				{
-					CHECK_EOF;
-					auto byte = *frame.ptr++;
-
-					const OpBlock* new_block;
-					if (byte == 0x5B) {
-						CHECK_EOF;
-						byte = *frame.ptr++;
-						new_block = &EXT_OPS[byte];
-					}
-					else if (is_name_char(byte)) {
-						if (auto status = handle_name(
-							frame,
-							true, op == Op::SuperName || op == Op::SuperNameUnresolved);
-							status != Status::Success) {
-							if (status == Status::NotFound && op == Op::SuperNameUnresolved) {
-								auto obj = ObjectRef::empty();
-								if (!objects.push(move(obj))) {
-									return Status::NoMemory;
-								}
-								break;
-							}
-							if (frames.size() != 1) {
-								unwind_stack();
-								continue;
-							}
-							else {
-								return status;
-							}
-						}
-						break;
-					}
-					else {
-						new_block = &OPS[byte];
-					}
 
-					if (new_block->handler == OpHandler::None) {
-						LOG << "qacpi internal error: unimplemented op " << byte << endlog;
-						return Status::Unsupported;
-					}
+				CHECK_EOF_NUM(remaining_data);
 
-					if (!frame.op_blocks.push({
-						.block = new_block,
+				if (!objects.push(FieldList {
+					.nodes {},
+					.connection {ObjectRef::empty()},
+					.offset = 0,
+					.frame {
+						.start = frame.ptr,
+						.end = frame.ptr + remaining_data,
+						.ptr = frame.ptr,
+						.parent_scope = nullptr,
+						.op_blocks {},
+						.data_buf = nullptr,
+						.data_buf_size = 0,
+						.objects_at_start = 0,
+						.loop_iterations = 0,
+						.need_result = false,
+						.need_load_result = false,
+						.is_method = false,
+						.exit_loop = false,
+						.verified = frame.verified,
+						.type = Frame::FieldList
+					},
+					.type = type,
+					.flags = flags,
+					.connect_field = false,
+					.connect_field_part2 = false
+				})) {
+					return Status::NoMemory;
+				}
+				continue;
+			}
+			OP_START(FieldList)
+			{
+				block.processed = true;
+				auto& list = objects[block.objects_at_start].get_unsafe<FieldList>();
+				if (list.connect_field) {
+					frame.ptr = list.frame.ptr;
+					block.processed = false;
+					if (!frame.op_blocks.push(OpBlockCtx {
+						.block = &TERM_ARG_BLOCK,
 						.objects_at_start = static_cast<uint32_t>(objects.size()),
 						.ip = 0,
 						.processed = false,
 						.need_result = true,
-						.as_ref = op == Op::SuperName
+						.as_ref = false
 					})) {
 						return Status::NoMemory;
 					}
 
-					break;
+					list.connect_field = false;
+					list.connect_field_part2 = true;
+					continue;
 				}
-				case Op::StartFieldList:
-				{
-					uint32_t remaining_data;
-					uint8_t flags = objects[objects.size() - 1].get_unsafe<PkgLength>().len;
-					decltype(Field::Normal) type;
-
-					if (block.block->handler == OpHandler::Field) {
-						auto len = objects[objects.size() - 3].get_unsafe<PkgLength>();
-						remaining_data = len.len - (frame.ptr - len.start);
-						type = Field::Normal;
-					}
-					else if (block.block->handler == OpHandler::IndexField) {
-						auto len = objects[objects.size() - 4].get_unsafe<PkgLength>();
-						remaining_data = len.len - (frame.ptr - len.start);
-						type = Field::Index;
-					}
-					else if (block.block->handler == OpHandler::BankField) {
-						auto len = objects[objects.size() - 5].get_unsafe<PkgLength>();
-						remaining_data = len.len - (frame.ptr - len.start);
-						type = Field::Bank;
-					}
-					else {
-						__builtin_unreachable();
-					}
-
-					CHECK_EOF_NUM(remaining_data);
-
-					if (!objects.push(FieldList {
-						.nodes {},
-						.connection {ObjectRef::empty()},
-						.offset = 0,
-						.frame {
-							.start = frame.ptr,
-							.end = frame.ptr + remaining_data,
-							.ptr = frame.ptr,
-							.prev_while_end = nullptr,
-							.parent_scope = nullptr,
-							.op_blocks {},
-							.prev_while_expiration = 0,
-							.data_buf = nullptr,
-							.data_buf_size = 0,
-							.objects_at_start = 0,
-							.need_result = false,
-							.need_load_result = false,
-							.is_method = false,
-							.type = Frame::FieldList
-						},
-						.type = type,
-						.flags = flags,
-						.connect_field = false,
-						.connect_field_part2 = false
-					})) {
-						return Status::NoMemory;
-					}
-					break;
+				else if (list.connect_field_part2) {
+					auto connection = objects.pop().get_unsafe<ObjectRef>();
+					list.frame.ptr = frame.ptr;
+					list.connection = move(connection);
+					list.connect_field_part2 = false;
 				}
-				case Op::FieldList:
-				{
-					auto& list = objects[block.objects_at_start].get_unsafe<FieldList>();
-					if (list.connect_field) {
-						frame.ptr = list.frame.ptr;
-						block.processed = false;
-						if (!frame.op_blocks.push(OpBlockCtx {
-							.block = &TERM_ARG_BLOCK,
-							.objects_at_start = static_cast<uint32_t>(objects.size()),
-							.ip = 0,
-							.processed = false,
-							.need_result = true,
-							.as_ref = false
-						})) {
-							return Status::NoMemory;
-						}
 
-						list.connect_field = false;
-						list.connect_field_part2 = true;
-						break;
-					}
-					else if (list.connect_field_part2) {
-						auto connection = objects.pop().get_unsafe<ObjectRef>();
-						list.frame.ptr = frame.ptr;
-						list.connection = move(connection);
-						list.connect_field_part2 = false;
-					}
-
-					if (list.frame.ptr == list.frame.end) {
-						break;
-					}
-					else {
-						if (auto status = parse_field(list, list.frame); status != Status::Success) {
-							if (frames.size() != 1) {
-								unwind_stack();
-								continue;
-							}
-							else {
-								return status;
-							}
+				if (list.frame.ptr != list.frame.end) {
+					if (auto status = parse_field(list, list.frame); status != Status::Success) {
+						if (frames.size() != 1) {
+							unwind_stack();
+							continue;
+						}
+						else {
+							return status;
 						}
-
-						block.processed = false;
 					}
-					break;
+
+					block.processed = false;
 				}
-				case Op::CallHandler:
-					__builtin_unreachable();
+				continue;
 			}
 		}
 	}
 }
 
 Interpreter::~Interpreter() {
+	reset();
+}
+
+void Interpreter::reset() {
 	auto mutex = global_locked_mutexes;
 	while (mutex) {
 		LOG << "qacpi warning: some mutexes were not unlocked at the end of the global scope" << endlog;
 		mutex->unlock();
 		mutex = mutex->next;
 	}
+	global_locked_mutexes = nullptr;
+
+	// the stacks keep their heap storage so that it can be reused by the next evaluation
+	while (!objects.is_empty()) {
+		objects.pop_discard();
+	}
+	while (!method_frames.is_empty()) {
+		method_frames.pop_discard();
+	}
+	while (!frames.is_empty()) {
+		frames.pop_discard();
+	}
+	while (!temps.is_empty()) {
+		temps.pop_discard();
+	}
+	temp_cursor = 0;
+
+	current_scope = context->get_root();
+	eval_node = nullptr;
+	budgeted = false;
+	async = false;
+	suspendable = false;
+	serialize_pending = false;
+	wait.type = WaitCondition::None;
 }
 
 static Status read_field_to_buffer(Field* field, uint8_t* dest) {
@@ -5714,51 +6652,51 @@ Status Interpreter::write_field(Field* field, const ObjectRef& value) {
 	return Status::Success;
 }
 
-Interpreter::MethodFrame::MethodFrame(Interpreter::MethodFrame&& other) noexcept {
-	for (int i = 0; i < 7; ++i) {
-		args[i] = move(other.args[i]);
-	}
-	for (int i = 0; i < 8; ++i) {
-		locals[i] = move(other.locals[i]);
+bool Interpreter::MethodFrame::init_load_table() {
+	auto* mem = allocate(sizeof(LoadTableInfo));
+	if (!mem) {
+		return false;
 	}
-	node_link = other.node_link;
-	mutex_link = other.mutex_link;
-	serialize_mutex = move(other.serialize_mutex);
-	table_target = move(other.table_target);
-	load_table_param = move(other.load_table_param);
-	load_table_param_path = move(other.load_table_param_path);
-	load_table_root_path = move(other.load_table_root_path);
-	other.moved = true;
+	load_table = construct<LoadTableInfo>(mem);
+	return true;
 }
 
 Interpreter::MethodFrame::~MethodFrame() {
-	if (!moved) {
-		if (serialize_mutex && serialize_mutex->handle) {
-			if (serialize_mutex->recursion) {
-				--serialize_mutex->recursion;
-			}
-			else {
-				serialize_mutex->unlock();
-			}
+	if (serialize_mutex && serialize_mutex->handle) {
+		Interpreter::unlock_serialized(*serialize_mutex);
+	}
+
+	Mutex* mutex = mutex_link;
+	while (mutex) {
+		LOG << "qacpi warning: some mutexes were not unlocked at the end of a method scope" << endlog;
+		mutex->unlock();
+		mutex = mutex->next;
+	}
+
+	if (!load_table || (!load_table->table_target && !load_table->param)) {
+		if (node_link) {
+			++context->ns_generation;
 		}
 
-		Mutex* mutex = mutex_link;
-		while (mutex) {
-			LOG << "qacpi warning: some mutexes were not unlocked at the end of a method scope" << endlog;
-			mutex->unlock();
-			mutex = mutex->next;
+		NamespaceNode* node = node_link;
+		while (node) {
+			node->parent->remove_child(node);
+
+			auto* next = node->link;
+			node->~NamespaceNode();
+			deallocate(node, sizeof(NamespaceNode));
+			node = next;
 		}
+	}
 
-		if (!table_target && !load_table_param) {
-			NamespaceNode* node = node_link;
-			while (node) {
-				node->parent->remove_child(node);
+	if (load_table) {
+		load_table->~LoadTableInfo();
+		deallocate(load_table, sizeof(LoadTableInfo));
+	}
 
-				auto* next = node->link;
-				node->~NamespaceNode();
-				qacpi_os_free(node, sizeof(NamespaceNode));
-				node = next;
-			}
+	for (int i = 0; i < 15; ++i) {
+		if (live_slots & 1 << i) {
+			slots.refs[i].~ObjectRef();
 		}
 	}
 }
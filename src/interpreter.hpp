@@ -2,12 +2,15 @@
 #include "qacpi/object.hpp"
 #include "qacpi/context.hpp"
 #include "qacpi/small_vec.hpp"
+#include "qacpi/segmented_stack.hpp"
 #include "ops.hpp"
 
 namespace qacpi {
 	struct Interpreter {
 		~Interpreter();
 
+		void reset();
+
 		Context* context;
 		uint8_t int_size {};
 
@@ -24,19 +27,21 @@ namespace qacpi {
 			const uint8_t* start;
 			const uint8_t* end;
 			const uint8_t* ptr;
-			const uint8_t* prev_while_end;
 			union {
 				NamespaceNode* parent_scope;
 				uint64_t expiration_time;
 			};
 			SmallVec<OpBlockCtx, 8> op_blocks;
-			uint64_t prev_while_expiration;
 			uint8_t* data_buf;
 			uint32_t data_buf_size;
 			uint32_t objects_at_start;
+			uint32_t loop_iterations;
 			bool need_result;
 			bool need_load_result;
 			bool is_method;
+			bool exit_loop;
+			// the code was accepted by verify_aml so operand bounds checks can be skipped
+			bool verified;
 			enum : uint8_t {
 				Scope,
 				Package,
@@ -52,34 +57,66 @@ namespace qacpi {
 
 			constexpr MethodFrame(const MethodFrame&) = delete;
 			constexpr MethodFrame& operator=(const MethodFrame&) = delete;
-			constexpr MethodFrame& operator=(MethodFrame&&) = delete;
-			MethodFrame(MethodFrame&& other) noexcept;
+
+			inline ObjectRef& arg(int index) {
+				return slot(index);
+			}
+
+			inline ObjectRef& local(int index) {
+				return slot(7 + index);
+			}
+
+			inline ObjectRef& slot(int index) {
+				if (!(live_slots & 1 << index)) {
+					construct<ObjectRef>(&slots.refs[index], ObjectRef::empty());
+					live_slots |= 1 << index;
+				}
+				return slots.refs[index];
+			}
+
+			struct LoadTableInfo {
+				ObjectRef table_target {ObjectRef::empty()};
+				ObjectRef param {ObjectRef::empty()};
+				String param_path {};
+				String root_path {};
+				const Table* table {};
+			};
+
+			bool init_load_table();
 
 			NamespaceNode* node_link {};
 			Mutex* mutex_link {};
 			SharedPtr<Mutex> serialize_mutex {SharedPtr<Mutex>::empty()};
-			ObjectRef args[7] {
-				ObjectRef::empty(), ObjectRef::empty(), ObjectRef::empty(),
-				ObjectRef::empty(), ObjectRef::empty(), ObjectRef::empty(),
-				ObjectRef::empty()};
-			ObjectRef locals[8] {
-				ObjectRef::empty(), ObjectRef::empty(), ObjectRef::empty(),
-				ObjectRef::empty(), ObjectRef::empty(), ObjectRef::empty(),
-				ObjectRef::empty(), ObjectRef::empty()
-			};
-			ObjectRef table_target {ObjectRef::empty()};
-			ObjectRef load_table_param {ObjectRef::empty()};
-			String load_table_param_path {};
-			String load_table_root_path {};
-			const Table* table {};
-			bool moved {};
+			// Arg0-6 followed by Local0-7, a slot is only constructed when its bit in live_slots is set
+			union Slots {
+				constexpr Slots() {}
+				constexpr ~Slots() {}
+
+				ObjectRef refs[15];
+			} slots;
+			uint16_t live_slots {};
+			// only allocated by Load and LoadTable
+			LoadTableInfo* load_table {};
+			SharedPtr<MethodCache> cache {SharedPtr<MethodCache>::empty()};
+			SharedPtr<MethodNames> names {SharedPtr<MethodNames>::empty()};
+			const uint8_t* aml {};
+			Context* context {};
 		};
 
 		NamespaceNode* create_or_get_node(StringView name, Context::SearchFlags flags);
+		NamespaceNode* create_or_get_node(const NamePath& path, Context::SearchFlags flags);
 
-		Status execute(const uint8_t* aml, uint32_t size);
+		Status execute(const uint8_t* aml, uint32_t size, bool verified);
 		Status invoke_method(NamespaceNode* node, ObjectRef& res, ObjectRef* args, int arg_count);
-		Status resolve_object(ObjectRef& object);
+		Status finish_method(ObjectRef& res, Status status);
+		void set_budget(const EvalBudget& budget);
+		bool out_of_budget();
+		Status resume(ObjectRef& res, const EvalBudget& budget);
+		bool still_waiting(decltype(WaitCondition::type) type, void* handle, uint64_t timeout_ms);
+		bool can_defer_package();
+		void* mutex_key();
+		Status lock_serialized(Mutex& mutex);
+		static void unlock_serialized(Mutex& mutex);
 		Status handle_name(Frame& frame, bool need_result, bool super_name);
 		Status try_convert(ObjectRef& object, ObjectRef& res, const ObjectType* types, int type_count);
 
@@ -91,10 +128,13 @@ namespace qacpi {
 			return try_convert(object, res, types, N);
 		}
 
+		static void sync_element_ref(Ref& ref);
+		static bool box_element_ref(Ref& ref);
+		static ObjectRef& unwrap_refs(ObjectRef& obj);
 		ObjectRef pop_and_unwrap_obj();
 
 		Status store_to_target(ObjectRef target, ObjectRef value);
-		static Status parse_name_str(Frame& frame, String& res);
+		static Status parse_name_path(Frame& frame, NamePath& res);
 
 		struct NormalFieldInfo {
 			ObjectRef owner;
@@ -127,8 +167,8 @@ namespace qacpi {
 		Status handle_op(Frame& frame, const OpBlockCtx& block, bool need_result);
 		Status parse();
 
-		SmallVec<Frame, 8> frames {};
-		SmallVec<MethodFrame, 8> method_frames {};
+		SegmentedStack<Frame, 8> frames {};
+		SegmentedStack<MethodFrame, 8> method_frames {};
 		NamespaceNode* current_scope {context->get_root()};
 
 		struct PkgLength {
@@ -140,10 +180,49 @@ namespace qacpi {
 			NamespaceNode* method_node;
 			uint8_t remaining;
 		};
-		SmallVec<Variant<PkgLength, ObjectRef, String, MethodArgs, FieldList>, 8> objects {};
+		SmallVec<Variant<PkgLength, ObjectRef, NamePath, MethodArgs, FieldList>, 8> objects {};
+
+		// Objects for temporaries and method slots of the current evaluation, dropped by reset.
+		// An entry is reused once it is the only reference to its object, so an object that
+		// ends up in the namespace or in the result stays alive as a normal heap object.
+		static constexpr uint32_t TEMP_COUNT = 32;
+		static constexpr uint32_t TEMP_PROBES = 4;
+		SmallVec<ObjectRef, TEMP_COUNT> temps {};
+		uint32_t temp_cursor {};
 
 		static Status parse_pkg_len(Frame& frame, PkgLength& res);
 
+		void use_method_cache(MethodFrame& method_frame, Method& method);
+		MethodCache::Entry* get_cache_entry(const Frame& frame);
+		NamespaceNode* get_cached_node(const Frame& frame, const MethodCache::Entry* entry);
+		void cache_node(MethodCache::Entry* entry, uint32_t name_size, NamespaceNode* node);
+		Status decode_op(Frame& frame, const OpBlock*& block);
+		// evaluates a side-effect-free integer expression of constants without using the object stack
+		bool fold_integer(Frame& frame, uint64_t& res);
+		Status push_integer(uint64_t value);
+		// returns an empty object for a temporary, see temps
+		ObjectRef new_temp();
+		Status decode_pkg_len(Frame& frame, PkgLength& res);
+
 		Mutex* global_locked_mutexes {};
+		Interpreter* next_free {};
+		// set by ops that can block so that the enclosing loop checks its timeout right away
+		bool loop_timer_check {};
+
+		// state of a budgeted evaluation, see Context::evaluate_budgeted
+		NamespaceNode* eval_node {};
+		uint64_t budget_statements {};
+		uint64_t budget_deadline {};
+		uint64_t suspend_time {};
+		uint32_t budget_ticks {};
+		bool budgeted {};
+		// blocking ops suspend instead, the suspended op is retried until wait is satisfied
+		bool async {};
+		// the evaluation may be suspended and resumed on another thread, so the mutexes it
+		// acquires are owned by the interpreter rather than the thread
+		bool suspendable {};
+		// the serialized method started by invoke_method is waiting for its mutex
+		bool serialize_pending {};
+		WaitCondition wait {};
 	};
 }
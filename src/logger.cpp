@@ -24,6 +24,22 @@ namespace qacpi {
 		return *this;
 	}
 
+	Logger& Logger::operator<<(const NamePath& path) {
+		if (path.absolute) {
+			operator<<("\\");
+		}
+		for (uint32_t i = 0; i < path.parent_count; ++i) {
+			operator<<("^");
+		}
+		for (uint32_t i = 0; i < path.segment_count; ++i) {
+			if (i) {
+				operator<<(".");
+			}
+			operator<<(StringView {reinterpret_cast<const char*>(path.segments + i * 4), 4});
+		}
+		return *this;
+	}
+
 	Logger& Logger::operator<<(uint64_t value) {
 		operator<<("0x");
 		char int_buf[16];
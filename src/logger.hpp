@@ -8,6 +8,7 @@ namespace qacpi {
 	struct Logger {
 		Logger& operator<<(StringView str);
 		Logger& operator<<(const String& str);
+		Logger& operator<<(const NamePath& path);
 		Logger& operator<<(uint64_t value);
 		Logger& operator<<(EndLog);
 
@@ -53,7 +53,7 @@ namespace qacpi {
 	}
 
 	NamespaceNode* NamespaceNode::create(const char* name) {
-		auto* ptr = qacpi_os_malloc(sizeof(NamespaceNode));
+		auto* ptr = allocate(sizeof(NamespaceNode));
 		if (!ptr) {
 			return nullptr;
 		}
@@ -65,13 +65,13 @@ namespace qacpi {
 	bool NamespaceNode::add_child(NamespaceNode* child) {
 		if (child_count == child_cap) {
 			size_t new_cap = child_cap < 8 ? 8 : child_cap * 2;
-			auto* new_ptr = static_cast<NamespaceNode**>(qacpi_os_malloc(new_cap * sizeof(NamespaceNode*)));
+			auto* new_ptr = static_cast<NamespaceNode**>(allocate(new_cap * sizeof(NamespaceNode*)));
 			if (!new_ptr) {
 				return false;
 			}
 			if (children) {
 				memcpy(new_ptr, children, child_count * sizeof(NamespaceNode*));
-				qacpi_os_free(children, child_cap * sizeof(NamespaceNode*));
+				deallocate(children, child_cap * sizeof(NamespaceNode*));
 			}
 			children = new_ptr;
 			child_cap = new_cap;
@@ -95,7 +95,7 @@ namespace qacpi {
 
 	NamespaceNode::~NamespaceNode() {
 		if (children) {
-			qacpi_os_free(children, child_cap * sizeof(NamespaceNode*));
+			deallocate(children, child_cap * sizeof(NamespaceNode*));
 		}
 	}
 }
@@ -15,7 +15,7 @@ namespace qacpi {
 	}
 
 	bool OpRegion::init() {
-		refs = static_cast<size_t*>(qacpi_os_malloc(sizeof(size_t)));
+		refs = static_cast<size_t*>(allocate(sizeof(size_t)));
 		if (!refs) {
 			return false;
 		}
@@ -43,7 +43,7 @@ namespace qacpi {
 	OpRegion::~OpRegion() {
 		if (refs) {
 			if (--*refs == 0) {
-				qacpi_os_free(refs, sizeof(*refs));
+				deallocate(refs, sizeof(*refs));
 				if (space == RegionSpace::SystemMemory) {
 					qacpi_os_unmap(handle, size);
 				}
@@ -547,4 +547,23 @@ namespace qacpi {
 
 		return res;
 	}();
+
+	constexpr Array<ByteClass, 0x100> BYTE_CLASSES = [] {
+		Array<ByteClass, 0x100> res {};
+
+		for (int i = 0; i < 0x100; ++i) {
+			if ((i >= 'A' && i <= 'Z') || (i >= '0' && i <= '9') || i == '_' ||
+				i == RootChar || i == ParentPrefixChar || i == DualNamePrefix || i == MultiNamePrefix) {
+				res[i] = ByteClass::NameChar;
+			}
+			else if (i == ExtOpPrefix) {
+				res[i] = ByteClass::ExtOpPrefix;
+			}
+			else if (OPS[i].handler != OpHandler::None) {
+				res[i] = ByteClass::Op;
+			}
+		}
+
+		return res;
+	}();
 }
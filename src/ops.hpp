@@ -121,6 +121,15 @@ namespace qacpi {
 		OpHandler handler;
 	};
 
+	enum class ByteClass : uint8_t {
+		Invalid,
+		Op,
+		ExtOpPrefix,
+		NameChar
+	};
+
 	extern const Array<OpBlock, 0x100> OPS;
 	extern const Array<OpBlock, 0x100> EXT_OPS;
+	// classification of the first byte of a term, used by the opcode decoder
+	extern const Array<ByteClass, 0x100> BYTE_CLASSES;
 }
@@ -0,0 +1,422 @@
+#include "package_literal.hpp"
+#include "aml_ops.hpp"
+#include "ops.hpp"
+#include "internal.hpp"
+
+namespace qacpi {
+	namespace {
+		constexpr uint32_t MAX_NESTING = 32;
+		// larger buffers can fail to allocate, that should happen when the package is created
+		constexpr uint64_t MAX_LAZY_BUFFER_SIZE = 0x10000;
+
+		struct Element {
+			enum : uint8_t {
+				Integer,
+				String,
+				Path,
+				Buffer,
+				Package
+			} type;
+			// the integer, the size operand of a buffer or NumElements of a package
+			uint64_t value;
+			// the string without the null terminator, buffer contents or package elements
+			const uint8_t* data;
+			uint32_t size;
+			NamePath path;
+		};
+
+		struct Decoder {
+			const uint8_t* ptr;
+			const uint8_t* end;
+
+			bool skip(uint32_t count) {
+				if (static_cast<uint32_t>(end - ptr) < count) {
+					return false;
+				}
+				ptr += count;
+				return true;
+			}
+
+			bool region(const uint8_t*& region_end) {
+				auto* start = ptr;
+				if (ptr == end) {
+					return false;
+				}
+
+				auto first = *ptr++;
+				uint8_t count = first >> 6;
+				uint32_t len;
+				if (count == 0) {
+					len = first & 0b111111;
+				}
+				else {
+					if (static_cast<uint32_t>(end - ptr) < count) {
+						return false;
+					}
+					len = first & 0xF;
+					for (int i = 0; i < count; ++i) {
+						len |= *ptr++ << (4 + i * 8);
+					}
+				}
+
+				if (len < static_cast<uint32_t>(ptr - start) || len > static_cast<uint32_t>(end - start)) {
+					return false;
+				}
+				region_end = start + len;
+				return true;
+			}
+
+			bool integer(uint64_t& value) {
+				if (ptr == end) {
+					return false;
+				}
+
+				uint32_t width;
+				switch (*ptr++) {
+					case ZeroOp:
+						value = 0;
+						return true;
+					case OneOp:
+						value = 1;
+						return true;
+					case OnesOp:
+						value = 0xFFFFFFFFFFFFFFFF;
+						return true;
+					case BytePrefix:
+						width = 1;
+						break;
+					case WordPrefix:
+						width = 2;
+						break;
+					case DWordPrefix:
+						width = 4;
+						break;
+					case QWordPrefix:
+						width = 8;
+						break;
+					default:
+						return false;
+				}
+
+				if (static_cast<uint32_t>(end - ptr) < width) {
+					return false;
+				}
+				value = 0;
+				memcpy(&value, ptr, width);
+				ptr += width;
+				return true;
+			}
+
+			bool name_path(NamePath& path) {
+				path = {};
+				if (*ptr == RootChar) {
+					path.absolute = true;
+					++ptr;
+				}
+				else {
+					while (ptr != end && *ptr == ParentPrefixChar) {
+						++path.parent_count;
+						++ptr;
+					}
+				}
+				if (ptr == end) {
+					return false;
+				}
+
+				if (*ptr == 0) {
+					++ptr;
+					path.segments = ptr;
+					return true;
+				}
+
+				path.segment_count = 1;
+				if (*ptr == DualNamePrefix) {
+					++ptr;
+					path.segment_count = 2;
+				}
+				else if (*ptr == MultiNamePrefix) {
+					++ptr;
+					if (ptr == end) {
+						return false;
+					}
+					path.segment_count = *ptr++;
+				}
+
+				path.segments = ptr;
+				return skip(path.segment_count * 4);
+			}
+
+			bool next(Element& elem) {
+				if (ptr == end) {
+					return false;
+				}
+
+				auto byte = *ptr;
+				const uint8_t* region_end;
+				switch (byte) {
+					case ZeroOp:
+					case OneOp:
+					case OnesOp:
+					case BytePrefix:
+					case WordPrefix:
+					case DWordPrefix:
+					case QWordPrefix:
+						elem.type = Element::Integer;
+						return integer(elem.value);
+					default:
+						break;
+				}
+
+				if (BYTE_CLASSES[byte] == ByteClass::NameChar) {
+					elem.type = Element::Path;
+					return name_path(elem.path);
+				}
+
+				++ptr;
+				switch (byte) {
+					case StringPrefix:
+						elem.type = Element::String;
+						elem.data = ptr;
+						while (ptr != end && *ptr) {
+							++ptr;
+						}
+						elem.size = ptr - elem.data;
+						return skip(1);
+					case BufferOp:
+					{
+						elem.type = Element::Buffer;
+						if (!region(region_end)) {
+							return false;
+						}
+						Decoder size {.ptr = ptr, .end = region_end};
+						if (!size.integer(elem.value) || elem.value > MAX_LAZY_BUFFER_SIZE) {
+							return false;
+						}
+						elem.data = size.ptr;
+						elem.size = region_end - size.ptr;
+						ptr = region_end;
+						return true;
+					}
+					case PackageOp:
+						elem.type = Element::Package;
+						if (!region(region_end) || ptr == region_end) {
+							return false;
+						}
+						elem.value = *ptr++;
+						elem.data = ptr;
+						elem.size = region_end - ptr;
+						ptr = region_end;
+						return true;
+					default:
+						return false;
+				}
+			}
+
+			// only called on lists that were accepted by scan, so it just counts
+			uint32_t count() {
+				uint32_t res = 0;
+				Element elem;
+				while (ptr != end && next(elem)) {
+					++res;
+				}
+				return res;
+			}
+		};
+
+		bool scan(
+			const uint8_t* aml,
+			uint32_t size,
+			uint32_t& init_count,
+			bool (*exists)(void* arg, const NamePath& path),
+			void* arg,
+			uint32_t depth) {
+			if (depth == MAX_NESTING) {
+				return false;
+			}
+
+			Decoder decoder {.ptr = aml, .end = aml + size};
+			init_count = 0;
+			Element elem;
+			while (decoder.ptr != decoder.end) {
+				if (!decoder.next(elem)) {
+					return false;
+				}
+				++init_count;
+
+				if (elem.type == Element::Path && exists(arg, elem.path)) {
+					return false;
+				}
+				else if (elem.type == Element::Package) {
+					uint32_t nested_count;
+					if (!scan(elem.data, elem.size, nested_count, exists, arg, depth + 1)) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+	}
+
+	bool scan_package_literal(
+		const uint8_t* aml,
+		uint32_t size,
+		uint32_t& init_count,
+		bool (*exists)(void* arg, const NamePath& path),
+		void* arg) {
+		return scan(aml, size, init_count, exists, arg, 0);
+	}
+
+	bool name_path_to_str(const NamePath& path, String& res) {
+		uint32_t prefix_size = path.absolute ? 1 : path.parent_count;
+		uint32_t size = prefix_size;
+		if (path.segment_count) {
+			size += path.segment_count * 5 - 1;
+		}
+
+		if (!res.init_with_size(size)) {
+			return false;
+		}
+
+		auto data = res.data();
+		memset(data, path.absolute ? '\\' : '^', prefix_size);
+		data += prefix_size;
+		for (uint32_t i = 0; i < path.segment_count; ++i) {
+			memcpy(data, path.segments + i * 4, 4);
+			data += 4;
+			if (i != path.segment_count - 1) {
+				*data++ = '.';
+			}
+		}
+
+		return true;
+	}
+
+	void Package::init_lazy(const uint8_t* aml, uint32_t aml_size, uint32_t new_size) {
+		data->aml = aml;
+		data->aml_size = aml_size;
+		data->element_count = new_size;
+	}
+
+	// nested packages are decoded by Package::materialize as they stay lazy
+	static bool decode_element(const Element& elem, ObjectRef& res) {
+		switch (elem.type) {
+			case Element::Integer:
+				res->data = elem.value;
+				return true;
+			case Element::String:
+			{
+				String str;
+				if (!str.init(reinterpret_cast<const char*>(elem.data), elem.size)) {
+					return false;
+				}
+				res->data = move(str);
+				return true;
+			}
+			case Element::Path:
+			{
+				String str;
+				if (!name_path_to_str(elem.path, str)) {
+					return false;
+				}
+				str.mark_as_path();
+				res->data = move(str);
+				return true;
+			}
+			case Element::Buffer:
+			{
+				uint32_t real_size = elem.value > elem.size ? elem.value : elem.size;
+				Buffer buf;
+				if (!buf.init_with_size(real_size)) {
+					return false;
+				}
+				if (real_size) {
+					memcpy(buf.data(), elem.data, elem.size);
+				}
+				res->data = move(buf);
+				return true;
+			}
+			case Element::Package:
+				break;
+		}
+		return false;
+	}
+
+	bool Package::materialize() {
+		if (!data->aml) {
+			return true;
+		}
+
+		Decoder decoder {.ptr = data->aml, .end = data->aml + data->aml_size};
+		Element elem;
+		uint32_t init_count = 0;
+		bool packed = true;
+		while (decoder.ptr != decoder.end && decoder.next(elem)) {
+			packed &= elem.type == Element::Integer;
+			++init_count;
+		}
+		packed &= init_count == data->element_count;
+
+		auto count = data->element_count;
+		auto aml = data->aml;
+		data->aml = nullptr;
+		data->element_count = 0;
+		decoder.ptr = aml;
+
+		if (packed) {
+			if (!init_integers(count)) {
+				init_lazy(aml, decoder.end - aml, count);
+				return false;
+			}
+			for (uint32_t i = 0; i < count; ++i) {
+				decoder.next(elem);
+				data->integers[i] = elem.value;
+			}
+			return true;
+		}
+
+		if (!init(count)) {
+			init_lazy(aml, decoder.end - aml, count);
+			return false;
+		}
+		uint32_t decoded = 0;
+		for (; decoded < count; ++decoded) {
+			auto& element = data->elements[decoded];
+			element = ObjectRef {};
+			if (!element) {
+				break;
+			}
+			if (decoded >= init_count) {
+				element->data = Uninitialized {};
+			}
+			else if (!decoder.next(elem)) {
+				break;
+			}
+			else if (elem.type == Element::Package) {
+				Decoder nested {.ptr = elem.data, .end = elem.data + elem.size};
+				uint32_t nested_count = nested.count();
+
+				Package pkg;
+				if (!pkg.data) {
+					break;
+				}
+				pkg.init_lazy(elem.data, elem.size, elem.value > nested_count ? elem.value : nested_count);
+				element->data = move(pkg);
+			}
+			else if (!decode_element(elem, element)) {
+				break;
+			}
+		}
+		if (decoded == count) {
+			return true;
+		}
+
+		// stay lazy so that the next access can try again
+		for (uint32_t i = 0; i < count; ++i) {
+			data->elements[i].~SharedPtr();
+		}
+		deallocate(data->elements, count * sizeof(ObjectRef));
+		data->elements = nullptr;
+		init_lazy(aml, decoder.end - aml, count);
+		return false;
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "qacpi/context.hpp"
+
+namespace qacpi {
+	// Checks that a PackageElementList only contains integer constants, strings, buffers with a
+	// constant size, packages of those and names for which exists returns false, such a list can
+	// be decoded by Package::materialize without the interpreter. Names are decoded as paths
+	// so a name that already exists has to be resolved by the interpreter.
+	bool scan_package_literal(
+		const uint8_t* aml,
+		uint32_t size,
+		uint32_t& init_count,
+		bool (*exists)(void* arg, const NamePath& path),
+		void* arg);
+
+	bool name_path_to_str(const NamePath& path, String& res);
+}
@@ -0,0 +1,420 @@
+#include "purity.hpp"
+#include "ops.hpp"
+#include "aml_ops.hpp"
+#include "qacpi/ns.hpp"
+
+namespace qacpi {
+	namespace {
+		// bounds the nesting of terms and calls together, deeper code is Impure
+		constexpr uint32_t MAX_ANALYZE_DEPTH = 32;
+
+		bool has_no_side_effects(OpHandler handler) {
+			switch (handler) {
+				case OpHandler::Constant:
+				case OpHandler::String:
+				case OpHandler::Local:
+				case OpHandler::Arg:
+				case OpHandler::Store:
+				case OpHandler::Concat:
+				case OpHandler::ConcatRes:
+				case OpHandler::CopyObject:
+				case OpHandler::Buffer:
+				case OpHandler::Package:
+				case OpHandler::DerefOf:
+				case OpHandler::Index:
+				case OpHandler::Add:
+				case OpHandler::Subtract:
+				case OpHandler::Increment:
+				case OpHandler::Decrement:
+				case OpHandler::Multiply:
+				case OpHandler::Divide:
+				case OpHandler::Shl:
+				case OpHandler::Shr:
+				case OpHandler::And:
+				case OpHandler::Nand:
+				case OpHandler::Or:
+				case OpHandler::Nor:
+				case OpHandler::Xor:
+				case OpHandler::Mod:
+				case OpHandler::Not:
+				case OpHandler::LAnd:
+				case OpHandler::LOr:
+				case OpHandler::LNot:
+				case OpHandler::LEqual:
+				case OpHandler::LGreater:
+				case OpHandler::LLess:
+				case OpHandler::FindSetLeftBit:
+				case OpHandler::FindSetRightBit:
+				case OpHandler::ToBuffer:
+				case OpHandler::ToInteger:
+				case OpHandler::ToDecimalString:
+				case OpHandler::ToHexString:
+				case OpHandler::ToBcd:
+				case OpHandler::FromBcd:
+				case OpHandler::SizeOf:
+				case OpHandler::ObjectType:
+				case OpHandler::Match:
+				case OpHandler::Revision:
+				case OpHandler::Timer:
+				case OpHandler::If:
+				case OpHandler::Else:
+				case OpHandler::While:
+				case OpHandler::Noop:
+				case OpHandler::Return:
+				case OpHandler::Break:
+				case OpHandler::Continue:
+					return true;
+				default:
+					return false;
+			}
+		}
+	}
+
+	// only walks code accepted by verify_aml, the bounds are still checked as call arguments
+	// are decoded based on the current namespace
+	struct PurityAnalyzer {
+		Context& ctx;
+		NamespaceNode* scope;
+		const uint8_t* ptr;
+		bool reads_args;
+		// named objects, the timer or non-constant callees
+		bool reads_state;
+		bool writes_locals;
+		// the depth limit was hit, callees are only cached when analyzed with the whole budget
+		bool truncated;
+
+		static MethodPurity classify(Context& ctx, NamespaceNode* node, uint32_t depth, bool& truncated) {
+			auto& method = node->get_object()->get_unsafe<Method>();
+			if (method.purity != MethodPurity::Unknown) {
+				return method.purity;
+			}
+			if (!method.verified) {
+				method.purity = MethodPurity::Impure;
+				return method.purity;
+			}
+			if (depth == MAX_ANALYZE_DEPTH) {
+				truncated = true;
+				return MethodPurity::Impure;
+			}
+
+			method.purity = MethodPurity::Analyzing;
+
+			PurityAnalyzer analyzer {
+				.ctx = ctx,
+				.scope = node,
+				.ptr = method.aml,
+				.reads_args = false,
+				.reads_state = false,
+				.writes_locals = false,
+				.truncated = false
+			};
+
+			// a local could hold a reference to a named object or an argument
+			if (!analyzer.term_list(method.aml + method.size, depth) ||
+				(analyzer.writes_locals && (analyzer.reads_args || analyzer.reads_state))) {
+				method.purity = MethodPurity::Impure;
+			}
+			else if (analyzer.reads_args || analyzer.reads_state) {
+				method.purity = MethodPurity::Pure;
+			}
+			else {
+				method.purity = MethodPurity::Constant;
+			}
+
+			auto purity = method.purity;
+			if (analyzer.truncated && depth) {
+				method.purity = MethodPurity::Unknown;
+				truncated = true;
+			}
+			return purity;
+		}
+
+		bool skip(const uint8_t* end, uint32_t count) {
+			if (static_cast<uint32_t>(end - ptr) < count) {
+				return false;
+			}
+			ptr += count;
+			return true;
+		}
+
+		bool name_path(const uint8_t* end, NamePath& path) {
+			path = {};
+			if (ptr == end) {
+				return false;
+			}
+
+			if (*ptr == RootChar) {
+				path.absolute = true;
+				++ptr;
+			}
+			else {
+				while (ptr != end && *ptr == ParentPrefixChar) {
+					++path.parent_count;
+					++ptr;
+				}
+			}
+			if (ptr == end) {
+				return false;
+			}
+
+			if (*ptr == 0) {
+				++ptr;
+				return true;
+			}
+
+			path.segment_count = 1;
+			if (*ptr == DualNamePrefix) {
+				++ptr;
+				path.segment_count = 2;
+			}
+			else if (*ptr == MultiNamePrefix) {
+				++ptr;
+				if (ptr == end) {
+					return false;
+				}
+				path.segment_count = *ptr++;
+			}
+
+			path.segments = ptr;
+			return skip(end, path.segment_count * 4);
+		}
+
+		bool region(const uint8_t* end, const uint8_t*& region_end) {
+			auto* start = ptr;
+			if (ptr == end) {
+				return false;
+			}
+
+			auto first = *ptr++;
+			uint8_t count = first >> 6;
+			uint32_t len;
+			if (count == 0) {
+				len = first & 0b111111;
+			}
+			else {
+				if (static_cast<uint32_t>(end - ptr) < count) {
+					return false;
+				}
+				len = first & 0xF;
+				for (int i = 0; i < count; ++i) {
+					len |= *ptr++ << (4 + i * 8);
+				}
+			}
+
+			if (len < static_cast<uint32_t>(ptr - start) || len > static_cast<uint32_t>(end - start)) {
+				return false;
+			}
+			region_end = start + len;
+			return true;
+		}
+
+		// a name that resolves to a method is a call unless it is an operand that is only inspected
+		bool name(const uint8_t* end, bool call, uint32_t depth) {
+			NamePath path;
+			if (!name_path(end, path)) {
+				return false;
+			}
+
+			auto* node = ctx.create_or_find_node(scope, nullptr, path, Context::SearchFlags::Search);
+			if (!node || !node->get_object()) {
+				return false;
+			}
+
+			auto& obj = node->get_object();
+			if (obj->get<Field>() || obj->get<OpRegion>()) {
+				return false;
+			}
+			reads_state = true;
+
+			auto* method = obj->get<Method>();
+			if (!method || !call) {
+				return true;
+			}
+
+			auto purity = classify(ctx, node, depth + 1, truncated);
+			if (purity != MethodPurity::Pure && purity != MethodPurity::Constant) {
+				return false;
+			}
+
+			for (int i = 0; i < method->arg_count; ++i) {
+				if (!term(end, false, depth + 1)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// only NullTarget and locals can be written
+		bool target(const uint8_t* end) {
+			if (ptr == end) {
+				return false;
+			}
+
+			auto byte = *ptr;
+			if (byte == ZeroOp) {
+				++ptr;
+				return true;
+			}
+			else if (byte >= Local0Op && byte <= Local7Op) {
+				++ptr;
+				writes_locals = true;
+				return true;
+			}
+			return false;
+		}
+
+		bool elements(const uint8_t* end, uint32_t depth) {
+			while (ptr != end) {
+				// names in packages are references that are never invoked
+				if (BYTE_CLASSES[*ptr] == ByteClass::NameChar) {
+					NamePath path;
+					if (!name_path(end, path)) {
+						return false;
+					}
+					reads_state = true;
+				}
+				else if (!term(end, false, depth)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool term_list(const uint8_t* end, uint32_t depth) {
+			while (ptr != end) {
+				if (!term(end, false, depth)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Index creates a reference, that is only allowed when it is dereferenced right away
+		bool term(const uint8_t* end, bool deref, uint32_t depth) {
+			if (ptr == end) {
+				return false;
+			}
+			if (depth == MAX_ANALYZE_DEPTH) {
+				truncated = true;
+				return false;
+			}
+
+			auto byte = *ptr;
+			const OpBlock* block;
+			switch (BYTE_CLASSES[byte]) {
+				case ByteClass::NameChar:
+					return name(end, true, depth);
+				case ByteClass::ExtOpPrefix:
+					if (end - ptr < 2) {
+						return false;
+					}
+					block = &EXT_OPS[ptr[1]];
+					ptr += 2;
+					break;
+				case ByteClass::Op:
+					block = &OPS[byte];
+					++ptr;
+					break;
+				default:
+					return false;
+			}
+
+			auto handler = block->handler;
+			if (!has_no_side_effects(handler) || (handler == OpHandler::Index && !deref)) {
+				return false;
+			}
+
+			switch (handler) {
+				case OpHandler::Constant:
+				{
+					uint32_t size = byte == BytePrefix ? 1 : byte == WordPrefix ? 2 : byte == DWordPrefix ? 4 :
+						byte == QWordPrefix ? 8 : 0;
+					return skip(end, size);
+				}
+				case OpHandler::String:
+					while (ptr != end && *ptr) {
+						++ptr;
+					}
+					return skip(end, 1);
+				case OpHandler::Arg:
+					reads_args = true;
+					return true;
+				case OpHandler::Timer:
+					reads_state = true;
+					return true;
+				default:
+					break;
+			}
+
+			bool inspects_operand = handler == OpHandler::SizeOf || handler == OpHandler::ObjectType;
+
+			const uint8_t* region_end = nullptr;
+			for (int i = 0; i < block->op_count; ++i) {
+				auto* op_end = region_end ? region_end : end;
+				switch (block->ops[i]) {
+					case Op::PkgLength:
+						if (!region(end, region_end)) {
+							return false;
+						}
+						break;
+					case Op::TermArg:
+						if (!term(op_end, handler == OpHandler::DerefOf, depth + 1)) {
+							return false;
+						}
+						break;
+					case Op::SuperName:
+						if (inspects_operand) {
+							if (op_end != ptr && BYTE_CLASSES[*ptr] == ByteClass::NameChar) {
+								if (!name(op_end, false, depth + 1)) {
+									return false;
+								}
+							}
+							else if (!term(op_end, true, depth + 1)) {
+								return false;
+							}
+						}
+						else if (!target(op_end)) {
+							return false;
+						}
+						break;
+					case Op::Byte:
+						if (!skip(op_end, 1)) {
+							return false;
+						}
+						break;
+					case Op::PkgElements:
+					case Op::VarPkgElements:
+						if (!elements(op_end, depth + 1)) {
+							return false;
+						}
+						break;
+					case Op::CallHandler:
+						break;
+					default:
+						return false;
+				}
+			}
+
+			if (!region_end) {
+				return true;
+			}
+
+			switch (handler) {
+				case OpHandler::Buffer:
+					ptr = region_end;
+					return true;
+				case OpHandler::If:
+				case OpHandler::Else:
+				case OpHandler::While:
+					return term_list(region_end, depth + 1);
+				default:
+					return ptr == region_end;
+			}
+		}
+	};
+
+	MethodPurity analyze_purity(Context& ctx, NamespaceNode* node) {
+		bool truncated = false;
+		return PurityAnalyzer::classify(ctx, node, 0, truncated);
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "qacpi/context.hpp"
+
+namespace qacpi {
+	// Classifies the body of the method in node and stores the result in it, names are resolved
+	// from the method scope so this should run once the namespace is loaded. Methods that use
+	// region fields, Notify, synchronization, create objects or store anywhere but to locals are
+	// Impure, as is anything that can't be analyzed.
+	MethodPurity analyze_purity(Context& ctx, NamespaceNode* node);
+}
@@ -1,5 +1,5 @@
 #include "qacpi/string.hpp"
-#include "qacpi/os.hpp"
+#include "qacpi/allocator.hpp"
 #include "internal.hpp"
 
 namespace qacpi {
@@ -15,17 +15,24 @@ namespace qacpi {
 	}
 
 	String::Data::~Data() {
-		if (ptr) {
-			qacpi_os_free(ptr, size + 1);
+		if (ptr && ptr != inline_storage) {
+			deallocate(ptr, size + 1);
 		}
 	}
 
+	char* String::alloc(size_t size) {
+		if (size < sizeof(_data->inline_storage)) {
+			return _data->inline_storage;
+		}
+		return static_cast<char*>(allocate(size + 1));
+	}
+
 	bool String::init(const char* str, size_t size) {
 		if (!_data) {
 			return false;
 		}
 
-		auto* new_ptr = static_cast<char*>(qacpi_os_malloc(size + 1));
+		auto* new_ptr = alloc(size);
 		if (!new_ptr) {
 			return false;
 		}
@@ -41,7 +48,7 @@ namespace qacpi {
 			return false;
 		}
 
-		auto* new_ptr = static_cast<char*>(qacpi_os_malloc(size + 1));
+		auto* new_ptr = alloc(size);
 		if (!new_ptr) {
 			return false;
 		}
@@ -53,6 +60,20 @@ namespace qacpi {
 
 	bool String::clone(const String& other) {
 		_is_path = other._is_path;
-		return init(other._data->ptr, other._data->size);
+		_data = other._data;
+		return true;
+	}
+
+	bool String::unshare() {
+		if (_data.is_unique()) {
+			return true;
+		}
+
+		String copy;
+		if (!copy.init(_data->ptr, _data->size)) {
+			return false;
+		}
+		_data = move(copy._data);
+		return true;
 	}
 }
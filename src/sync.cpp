@@ -23,14 +23,14 @@ namespace qacpi {
 		return init();
 	}
 
-	bool Mutex::is_owned_by_thread() {
-		return __atomic_load_n(&owner, __ATOMIC_ACQUIRE) == qacpi_os_get_tid();
+	bool Mutex::is_owned_by(void* key) {
+		return __atomic_load_n(&owner, __ATOMIC_ACQUIRE) == key;
 	}
 
-	Status Mutex::lock(uint16_t timeout_ms) {
+	Status Mutex::lock(uint16_t timeout_ms, void* key) {
 		auto status = qacpi_os_mutex_lock(handle, timeout_ms);
 		if (status == Status::Success) {
-			owner = qacpi_os_get_tid();
+			owner = key;
 		}
 		return status;
 	}
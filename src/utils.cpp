@@ -293,6 +293,8 @@ namespace qacpi {
 				return "end of resources";
 			case Status::InvalidResource:
 				return "invalid resource";
+			case Status::Suspended:
+				return "evaluation suspended";
 		}
 		return "";
 	}
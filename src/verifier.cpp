@@ -0,0 +1,326 @@
+#include "verifier.hpp"
+#include "ops.hpp"
+#include "aml_ops.hpp"
+
+using namespace qacpi;
+
+namespace {
+	constexpr uint32_t MAX_VERIFY_DEPTH = 128;
+
+	bool is_statement(OpHandler handler) {
+		switch (handler) {
+			case OpHandler::Name:
+			case OpHandler::Method:
+			case OpHandler::Alias:
+			case OpHandler::Scope:
+			case OpHandler::Device:
+			case OpHandler::External:
+			case OpHandler::Mutex:
+			case OpHandler::Event:
+			case OpHandler::CreateField:
+			case OpHandler::CreateDWordField:
+			case OpHandler::CreateWordField:
+			case OpHandler::CreateByteField:
+			case OpHandler::CreateBitField:
+			case OpHandler::CreateQWordField:
+			case OpHandler::Stall:
+			case OpHandler::Sleep:
+			case OpHandler::Signal:
+			case OpHandler::Reset:
+			case OpHandler::Release:
+			case OpHandler::Fatal:
+			case OpHandler::If:
+			case OpHandler::Else:
+			case OpHandler::While:
+			case OpHandler::Noop:
+			case OpHandler::Return:
+			case OpHandler::Break:
+			case OpHandler::Continue:
+			case OpHandler::BreakPoint:
+			case OpHandler::OpRegion:
+			case OpHandler::Field:
+			case OpHandler::PowerRes:
+			case OpHandler::Processor:
+			case OpHandler::ThermalZone:
+			case OpHandler::Notify:
+			case OpHandler::DataRegion:
+			case OpHandler::IndexField:
+			case OpHandler::BankField:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	struct Verifier {
+		const uint8_t* ptr;
+
+		bool skip(const uint8_t* end, uint32_t count) {
+			if (static_cast<uint32_t>(end - ptr) < count) {
+				return false;
+			}
+			ptr += count;
+			return true;
+		}
+
+		bool name_path(const uint8_t* end) {
+			if (ptr == end) {
+				return false;
+			}
+
+			if (*ptr == RootChar) {
+				++ptr;
+			}
+			else {
+				while (ptr != end && *ptr == ParentPrefixChar) {
+					++ptr;
+				}
+			}
+			if (ptr == end) {
+				return false;
+			}
+
+			uint32_t num_segs = 1;
+			if (*ptr == 0) {
+				++ptr;
+				return true;
+			}
+			else if (*ptr == DualNamePrefix) {
+				++ptr;
+				num_segs = 2;
+			}
+			else if (*ptr == MultiNamePrefix) {
+				++ptr;
+				if (ptr == end) {
+					return false;
+				}
+				num_segs = *ptr++;
+			}
+
+			return skip(end, num_segs * 4);
+		}
+
+		bool pkg_len(const uint8_t* end, uint32_t& len) {
+			if (ptr == end) {
+				return false;
+			}
+
+			auto first = *ptr++;
+			uint8_t count = first >> 6;
+
+			if (count == 0) {
+				len = first & 0b111111;
+			}
+			else {
+				if (static_cast<uint32_t>(end - ptr) < count) {
+					return false;
+				}
+				len = first & 0xF;
+				for (int i = 0; i < count; ++i) {
+					len |= *ptr++ << (4 + i * 8);
+				}
+			}
+			return true;
+		}
+
+		bool region(const uint8_t* end, const uint8_t*& region_end) {
+			auto* start = ptr;
+			uint32_t len;
+			if (!pkg_len(end, len) ||
+				len < static_cast<uint32_t>(ptr - start) ||
+				len > static_cast<uint32_t>(end - start)) {
+				return false;
+			}
+			region_end = start + len;
+			return true;
+		}
+
+		bool field_list(const uint8_t* end, uint32_t depth) {
+			while (ptr != end) {
+				auto byte = *ptr;
+				uint32_t len;
+				// ReservedField
+				if (byte == 0x0) {
+					++ptr;
+					if (!pkg_len(end, len)) {
+						return false;
+					}
+				}
+				// AccessField and ExtendedAccessField
+				else if (byte == 0x1 || byte == 0x3) {
+					if (!skip(end, byte == 0x1 ? 3 : 4)) {
+						return false;
+					}
+				}
+				// ConnectField, the buffer is executed as a term
+				else if (byte == 0x2) {
+					++ptr;
+					if (ptr == end) {
+						return false;
+					}
+					bool call = false;
+					if (BYTE_CLASSES[*ptr] == ByteClass::NameChar) {
+						if (!name_path(end)) {
+							return false;
+						}
+					}
+					else if (!term(end, true, false, depth + 1, call)) {
+						return false;
+					}
+				}
+				// NamedField
+				else if (!skip(end, 4) || !pkg_len(end, len)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// a method call can take any number of the following terms as arguments,
+		// that doesn't matter within a list of terms but it does for raw operands.
+		bool term_list(const uint8_t* end, bool values, uint32_t depth) {
+			while (ptr != end) {
+				bool call = false;
+				if (!term(end, values, false, depth, call)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// call is set if the term contains a name that might be a method call
+		bool term(const uint8_t* end, bool value, bool super_name, uint32_t depth, bool& call) {
+			if (ptr == end || depth == MAX_VERIFY_DEPTH) {
+				return false;
+			}
+
+			auto byte = *ptr;
+			const OpBlock* block;
+			switch (BYTE_CLASSES[byte]) {
+				case ByteClass::NameChar:
+					call = !super_name;
+					return name_path(end);
+				case ByteClass::ExtOpPrefix:
+					if (end - ptr < 2) {
+						return false;
+					}
+					block = &EXT_OPS[ptr[1]];
+					ptr += 2;
+					break;
+				case ByteClass::Op:
+					block = &OPS[byte];
+					++ptr;
+					break;
+				default:
+					return false;
+			}
+
+			if (block->handler == OpHandler::None || (value && is_statement(block->handler))) {
+				return false;
+			}
+
+			if (block->handler == OpHandler::Constant) {
+				uint32_t size = byte == BytePrefix ? 1 : byte == WordPrefix ? 2 : byte == DWordPrefix ? 4 :
+					byte == QWordPrefix ? 8 : 0;
+				return skip(end, size);
+			}
+			else if (block->handler == OpHandler::String) {
+				while (ptr != end && *ptr) {
+					++ptr;
+				}
+				return skip(end, 1);
+			}
+
+			const uint8_t* region_end = nullptr;
+			for (int i = 0; i < block->op_count; ++i) {
+				auto* op_end = region_end ? region_end : end;
+				switch (block->ops[i]) {
+					case Op::PkgLength:
+						if (!region(end, region_end)) {
+							return false;
+						}
+						break;
+					case Op::TermArg:
+					case Op::SuperName:
+					case Op::SuperNameUnresolved:
+					{
+						bool sub_call = false;
+						if (!term(op_end, true, block->ops[i] != Op::TermArg, depth + 1, sub_call)) {
+							return false;
+						}
+						call |= sub_call;
+						break;
+					}
+					case Op::Byte:
+						if (call || !skip(op_end, 1)) {
+							return false;
+						}
+						break;
+					case Op::Word:
+						if (call || !skip(op_end, 2)) {
+							return false;
+						}
+						break;
+					case Op::DWord:
+						if (call || !skip(op_end, 4)) {
+							return false;
+						}
+						break;
+					case Op::NameString:
+						if (call || !name_path(op_end)) {
+							return false;
+						}
+						break;
+					case Op::PkgElements:
+					case Op::VarPkgElements:
+						if (!term_list(op_end, true, depth + 1)) {
+							return false;
+						}
+						// the elements are the rest of the package
+						call = false;
+						break;
+					case Op::StartFieldList:
+						if (call || !field_list(op_end, depth + 1)) {
+							return false;
+						}
+						break;
+					case Op::FieldList:
+					case Op::MethodArgs:
+					case Op::CallHandler:
+						break;
+				}
+			}
+
+			if (!region_end) {
+				return true;
+			}
+
+			switch (block->handler) {
+				case OpHandler::Buffer:
+					if (call) {
+						return false;
+					}
+					ptr = region_end;
+					return true;
+				case OpHandler::Scope:
+				case OpHandler::Device:
+				case OpHandler::Method:
+				case OpHandler::If:
+				case OpHandler::Else:
+				case OpHandler::While:
+				case OpHandler::Processor:
+				case OpHandler::PowerRes:
+				case OpHandler::ThermalZone:
+					call = false;
+					return term_list(region_end, false, depth + 1);
+				default:
+					return ptr == region_end;
+			}
+		}
+	};
+}
+
+bool qacpi::verify_aml(const uint8_t* aml, uint32_t size) {
+	Verifier verifier {.ptr = aml};
+	return verifier.term_list(aml + size, false, 0);
+}
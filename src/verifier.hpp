@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+
+namespace qacpi {
+	// Checks that a term list is well-formed: every opcode is known, every PkgLength stays
+	// within its parent, every fixed size operand fits and value operands aren't statements.
+	// Returns false if that can't be proven, the code then has to run with all checks enabled.
+	bool verify_aml(const uint8_t* aml, uint32_t size);
+}
@@ -38,14 +38,16 @@ class TestCase(ABC):
 
 class TestCaseWithMain(TestCase):
     def __init__(
-        self, path: str, name: str, rtype: str, value: str
+        self, path: str, name: str, rtype: str, value: str,
+        runner_args: List[str]
     ) -> None:
         super().__init__(path, f"{os.path.basename(path)}:{name}")
         self.rtype = rtype
         self.value = value
+        self.runner_args = runner_args
 
     def extra_runner_args(self) -> List[str]:
-        return ["--expect", self.rtype, self.value]
+        return ["--expect", self.rtype, self.value, *self.runner_args]
 
 
 class TestCaseHardwareBlob(TestCase):
@@ -145,7 +147,9 @@ def generate_large_test_cases(extractor: str, bin_dir: str) -> List[TestCase]:
     return test_cases
 
 
-def get_case_name_and_expected_result(case: str) -> Tuple[str, str, str]:
+def get_case_name_and_expected_result(
+    case: str
+) -> Tuple[str, str, str, List[str]]:
     with open(case) as tc:
         name = tc.readline()
         name = name[name.find(":") + 1:].strip()
@@ -154,7 +158,13 @@ def get_case_name_and_expected_result(case: str) -> Tuple[str, str, str]:
         expected_line = expected_line[expected_line.find(":") + 1:].strip()
         expected = [val.strip() for val in expected_line.split("=>")]
 
-        return name, expected[0], expected[1]
+        # an optional third line passes extra arguments to the runner
+        runner_line = tc.readline()
+        runner_args = []
+        if runner_line.startswith("// Runner:"):
+            runner_args = runner_line[runner_line.find(":") + 1:].split()
+
+        return name, expected[0], expected[1], runner_args
 
 
 class TestHeaderFooter:
@@ -211,14 +221,17 @@ def compile_test_cases(
     return compiled_cases
 
 
-def run_tests(cases: List[TestCase], runner: str, skipped: int) -> bool:
+def run_tests(
+    cases: List[TestCase], runner: str, skipped: int,
+    mode_args: Tuple[str, ...] = ()
+) -> bool:
     fail_count = 0
 
     for case in cases:
         print(f"{case.name}...", end=" ", flush=True)
 
         proc = subprocess.Popen(
-            [runner, case.path, *case.extra_runner_args()],
+            [runner, case.path, *case.extra_runner_args(), *mode_args],
             stdout=subprocess.PIPE, stderr=subprocess.PIPE,
             universal_newlines=True
         )
@@ -354,8 +367,17 @@ def main() -> int:
     base_test_cases = compile_test_cases(
         test_cases, test_compiler, bin_dir
     )
+    skipped = len(test_cases) - len(base_test_cases)
     with TestHeaderFooter("AML Tests"):
-        ret = run_tests(base_test_cases, test_runner, len(test_cases) - len(base_test_cases))
+        ret = run_tests(base_test_cases, test_runner, skipped)
+
+    # the same cases suspended after every statement and on every blocking op
+    for mode, mode_args in (("Budgeted", ("--budget", "1")),
+                            ("Async", ("--async",))):
+        with TestHeaderFooter(f"AML Tests ({mode})"):
+            ret = run_tests(
+                base_test_cases, test_runner, skipped, mode_args
+            ) and ret
 
     if args.large:
         large_test_cases = generate_large_test_cases(
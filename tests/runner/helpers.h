@@ -3,6 +3,7 @@
 #include "qacpi/tables.hpp"
 
 extern bool g_expect_virtual_addresses;
+extern bool g_fail_allocations;
 
 template <typename ExprT>
 class ScopeGuard {
@@ -24,6 +24,7 @@
 std::unordered_map<uint64_t, uint8_t> memory;
 std::unordered_map<void*, bool> virt_allocs;
 bool g_expect_virtual_addresses = true;
+bool g_fail_allocations = false;
 
 void* qacpi_os_map(uintptr_t addr, size_t size) {
 	if (g_expect_virtual_addresses) {
@@ -77,6 +78,9 @@ qacpi::Status qacpi_os_pci_write(qacpi::PciAddress, uint64_t, uint8_t, uint64_t)
 }
 
 void* qacpi_os_malloc(size_t size) {
+	if (g_fail_allocations) {
+		return nullptr;
+	}
 	return malloc(size);
 }
 
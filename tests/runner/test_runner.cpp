@@ -2,8 +2,10 @@
 #include <filesystem>
 #include <string>
 #include <string_view>
+#include <thread>
 #include "qacpi/context.hpp"
 #include "qacpi/ns.hpp"
+#include "qacpi/os.hpp"
 
 #include "helpers.h"
 #include "argparser.h"
@@ -214,7 +216,10 @@ struct SdtHeader {
 
 static void run_test(
     std::string_view dsdt_path, const std::vector<std::string>& ssdt_paths,
-	qacpi::ObjectType expected_type, std::string_view expected_value
+	qacpi::ObjectType expected_type, std::string_view expected_value,
+	uint64_t budget, bool async, const std::vector<std::string>& pre_evaluate,
+	bool repeat_on_thread, bool interleave, const std::vector<std::string>& batch,
+	bool batch_no_memory
 )
 {
 	qacpi::RsdpHeader rsdp {};
@@ -298,10 +303,152 @@ static void run_test(
     if (expected_type == qacpi::ObjectType::Uninitialized) // We're done with emulation mode
 		return;
 
-	auto ret = qacpi::ObjectRef::empty();
-	st = ctx.evaluate("\\MAIN", ret);
-    ensure_ok_status(st);
-    validate_ret_against_expected(ret, expected_type, expected_value);
+	// evaluated through the api first, e.g. so that constant methods are memoized before MAIN calls them
+	for (auto& name : pre_evaluate) {
+		auto pre_ret = qacpi::ObjectRef::empty();
+		st = ctx.evaluate(qacpi::StringView {name.data(), name.size()}, pre_ret);
+		ensure_ok_status(st);
+	}
+
+	// the statuses and results of the whole batch are compared against the expected string
+	if (!batch.empty()) {
+		std::vector<qacpi::EvalRequest> requests;
+		for (auto& name : batch)
+			requests.push_back({ctx.get_root(), qacpi::StringView {name.data(), name.size()}, nullptr, 0});
+		std::vector<qacpi::ObjectRef> results(batch.size(), qacpi::ObjectRef::empty());
+		// never returned by evaluate_batch, shows up in the summary if a status isn't set
+		std::vector<qacpi::Status> statuses(batch.size(), qacpi::Status::Suspended);
+
+		// a suspended evaluation holds the idle interpreter so the batch has to allocate one
+		qacpi::Interpreter* held = nullptr;
+		if (batch_no_memory) {
+			auto ret = qacpi::ObjectRef::empty();
+			st = ctx.evaluate_budgeted("\\MAIN", ret, {.statements = 1, .time_ms = 0}, held);
+			if (st != qacpi::Status::Suspended)
+				throw std::runtime_error("\\MAIN must run for more than one statement");
+			g_fail_allocations = true;
+		}
+
+		st = ctx.evaluate_batch(requests.data(), results.data(), statuses.data(), requests.size());
+		g_fail_allocations = false;
+		if (held)
+			ctx.abort_evaluation(held);
+		if (st != (batch_no_memory ? qacpi::Status::NoMemory : qacpi::Status::Success))
+			throw std::runtime_error(std::string("unexpected batch status: ") + status_to_str(st));
+
+		std::string summary;
+		for (size_t i = 0; i < batch.size(); ++i) {
+			if (i)
+				summary += "; ";
+			summary += status_to_str(statuses[i]);
+			if (statuses[i] != qacpi::Status::Success)
+				continue;
+
+			summary += ": ";
+			if (auto integer = results[i]->get<uint64_t>())
+				summary += std::to_string(*integer);
+			else if (auto str = results[i]->get<qacpi::String>())
+				summary += std::string_view(str->data(), str->size());
+			else
+				summary += object_type_to_str(object_get_type(&results[i]));
+		}
+
+		if (expected_type != qacpi::ObjectType::String || summary != expected_value)
+			throw std::runtime_error("batch returned '" + summary + "', expected '" +
+			                         std::string(expected_value) + "'");
+		return;
+	}
+
+	auto evaluate_main = [&]() {
+		auto ret = qacpi::ObjectRef::empty();
+		qacpi::Status st;
+		if (async) {
+			qacpi::Interpreter* eval;
+			qacpi::WaitCondition wait {};
+			st = ctx.evaluate_async("\\MAIN", ret, {.statements = budget, .time_ms = 0}, eval, wait);
+			while (st == qacpi::Status::Suspended) {
+				// sleep until the deadline, mutexes and events are polled
+				auto now = qacpi_os_timer();
+				if (wait.type == qacpi::WaitCondition::Sleep && wait.deadline > now)
+					qacpi_os_sleep((wait.deadline - now + 9999) / 10000);
+				else if (wait.type != qacpi::WaitCondition::None)
+					qacpi_os_sleep(1);
+				st = ctx.resume_async(eval, ret, {.statements = budget, .time_ms = 0}, wait);
+			}
+		}
+		else if (budget) {
+			qacpi::Interpreter* eval;
+			st = ctx.evaluate_budgeted("\\MAIN", ret, {.statements = budget, .time_ms = 0}, eval);
+			while (st == qacpi::Status::Suspended) {
+				st = ctx.resume(eval, ret, {.statements = budget, .time_ms = 0});
+			}
+		}
+		else {
+			st = ctx.evaluate("\\MAIN", ret);
+		}
+		ensure_ok_status(st);
+		validate_ret_against_expected(ret, expected_type, expected_value);
+	};
+
+	// two evaluations at once on one thread, each one waits for the mutexes the other one holds
+	auto evaluate_main_interleaved = [&]() {
+		struct Evaluation {
+			qacpi::Interpreter* eval;
+			qacpi::WaitCondition wait;
+			qacpi::ObjectRef ret;
+			qacpi::Status st;
+		};
+		Evaluation evals[2] {
+			{nullptr, {}, qacpi::ObjectRef::empty(), qacpi::Status::Success},
+			{nullptr, {}, qacpi::ObjectRef::empty(), qacpi::Status::Success}
+		};
+
+		for (auto& e : evals)
+			e.st = ctx.evaluate_async("\\MAIN", e.ret, {.statements = budget, .time_ms = 0}, e.eval, e.wait);
+
+		while (evals[0].st == qacpi::Status::Suspended || evals[1].st == qacpi::Status::Suspended) {
+			bool waiting = true;
+			for (auto& e : evals) {
+				if (e.st != qacpi::Status::Suspended)
+					continue;
+				e.st = ctx.resume_async(e.eval, e.ret, {.statements = budget, .time_ms = 0}, e.wait);
+				if (e.st == qacpi::Status::Suspended && e.wait.type == qacpi::WaitCondition::None)
+					waiting = false;
+			}
+			if (waiting)
+				qacpi_os_sleep(1);
+		}
+
+		for (auto& e : evals) {
+			ensure_ok_status(e.st);
+			validate_ret_against_expected(e.ret, expected_type, expected_value);
+		}
+	};
+
+	if (interleave && async) {
+		evaluate_main_interleaved();
+	}
+	else {
+		evaluate_main();
+		if (interleave)
+			evaluate_main();
+	}
+
+	// mutexes left locked by the first evaluation deadlock a second one from another thread
+	if (repeat_on_thread) {
+		std::exception_ptr error;
+		std::thread thread([&]() {
+			try {
+				evaluate_main();
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+		});
+		thread.join();
+		if (error)
+			std::rethrow_exception(error);
+	}
 }
 
 int main(int argc, char** argv)
@@ -327,6 +474,35 @@ int main(int argc, char** argv)
 			"while-loop-timeout", 't',
 			"number of seconds to use for the while loop timeout"
 		)
+		.add_param(
+			"budget", 'b',
+			"evaluate \\MAIN in slices of at most this many statements"
+		)
+		.add_flag(
+			"async", 'a',
+			"evaluate \\MAIN asynchronously, suspending on Sleep, Acquire and Wait"
+		)
+		.add_list(
+			"pre-evaluate", 'p', "a list of names to evaluate before \\MAIN"
+		)
+		.add_flag(
+			"repeat-on-thread", 'T',
+			"evaluate \\MAIN again on another thread and expect the same result"
+		)
+		.add_list(
+			"batch", 'B',
+			"evaluate these children of the root with evaluate_batch instead of \\MAIN and "
+			"expect a string of the statuses and results"
+		)
+		.add_flag(
+			"batch-no-memory", 'M',
+			"fail allocations during --batch while \\MAIN holds the idle interpreter"
+		)
+		.add_flag(
+			"interleave", 'i',
+			"with --async evaluate \\MAIN twice at once on one thread, otherwise "
+			"twice in a row, and expect the same result from both"
+		)
 		.add_param(
 			"log-level", 'l',
 			"log level to set, one of: debug, trace, info, warning, error"
@@ -357,7 +533,11 @@ int main(int argc, char** argv)
             expected_value = expect[1];
         }
 
-        run_test(dsdt_path_or_keyword, args.get_list_or("extra-tables", {}), expected_type, expected_value);
+        run_test(dsdt_path_or_keyword, args.get_list_or("extra-tables", {}), expected_type, expected_value,
+                 args.get_uint_or("budget", 0), args.is_set("async"),
+                 args.get_list_or("pre-evaluate", {}), args.is_set("repeat-on-thread"),
+                 args.is_set("interleave"), args.get_list_or("batch", {}),
+                 args.is_set("batch-no-memory"));
     } catch (const std::exception& ex) {
         std::cerr << "unexpected error: " << ex.what() << std::endl;
         return 1;